@@ -4,11 +4,26 @@
 #include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
 
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
 namespace esphome {
 namespace aic3104 {
 
 static const char *const TAG = "aic3104";
 
+// Bytes on the wire per register access, address byte(s) included
+static const size_t REG_WRITE_BUS_BYTES = 3;
+static const size_t REG_READ_BUS_BYTES = 4;
+
+// Output level registers in the order of their power status bits in register 94 (D5..D0)
+static const uint8_t OUTPUT_LEVEL_REGISTERS[] = {AIC3104_HPLOUT_LEVEL, AIC3104_HPLCOM_LEVEL,   AIC3104_HPROUT_LEVEL,
+                                                 AIC3104_HPRCOM_LEVEL, AIC3104_LEFT_LOP_LEVEL, AIC3104_RIGHT_LOP_LEVEL};
+static const size_t NUM_OUTPUTS = sizeof(OUTPUT_LEVEL_REGISTERS);
+// Longest power-on delay (4 s) plus the slowest ramp, with margin
+static const uint32_t WAKE_TIMEOUT_US = 5000000;
+
 #define ERROR_CHECK(err, msg) \
   if (!(err)) { \
     ESP_LOGE(TAG, msg); \
@@ -16,13 +31,133 @@ static const char *const TAG = "aic3104";
     return; \
   }
 
+struct ClockConfig {
+  bool use_pll;
+  uint8_t q;   // CLKDIV: fsref = MCLK / (128 * Q)
+  uint8_t p;   // PLL: fsref = MCLK * J.D * R / (2048 * P)
+  uint8_t r;
+  uint8_t j;
+  uint16_t d;
+};
+
+// Register 2 divides fsref (48 kHz or 44.1 kHz) in half steps: 0 = /1, 1 = /1.5, ... 10 = /6.
+static bool compute_sample_rate_divider(uint32_t sample_rate, uint32_t &fsref, uint8_t &divider) {
+  static const uint32_t FSREF_RATES[] = {48000, 44100};
+  for (uint32_t ref : FSREF_RATES) {
+    if (sample_rate == 0 || (2 * ref) % sample_rate != 0) {
+      continue;
+    }
+    uint32_t half_steps = 2 * ref / sample_rate;
+    if (half_steps < 2 || half_steps > 12) {
+      continue;
+    }
+    fsref = ref;
+    divider = half_steps - 2;
+    return true;
+  }
+  return false;
+}
+
+// Prefers the plain clock divider when MCLK is an exact multiple of 128 * fsref, otherwise
+// searches for PLL settings within the datasheet limits (2-20 MHz PLL input, 4 <= J <= 55,
+// fractional D only with R = 1 and a PLL input of at least 10 MHz).
+static bool compute_clock_config(uint32_t mclk, uint32_t fsref, ClockConfig &config) {
+  if (mclk % (128 * fsref) == 0) {
+    uint32_t q = mclk / (128 * fsref);
+    if (q >= 2 && q <= 17) {
+      config = {false, (uint8_t) q, 1, 1, 0, 0};
+      return true;
+    }
+  }
+
+  for (uint8_t p = 1; p <= 8; p++) {
+    uint32_t pll_in = mclk / p;
+    if (pll_in < 2000000) {
+      break;
+    }
+    if (pll_in > 20000000) {
+      continue;
+    }
+    for (uint8_t r = 1; r <= 16; r++) {
+      uint64_t k = 2048ULL * fsref * p * 10000 / ((uint64_t) mclk * r);  // J.D scaled by 10000
+      uint32_t j = k / 10000;
+      uint16_t d = k % 10000;
+      if (j < 4 || j > 55) {
+        continue;
+      }
+      if (d != 0 && (r != 1 || pll_in < 10000000)) {
+        continue;
+      }
+      config = {true, 2, p, r, (uint8_t) j, d};
+      return true;
+    }
+  }
+  return false;
+}
+
 void AIC3104::setup() {
-  // do nothing
+  if (this->sample_rate_ != 0) {
+    ERROR_CHECK(this->write_clocks_(this->sample_rate_), "Configuring codec clocks failed");
+  }
+
+  if (this->idle_timeout_ != 0) {
+    // Only the timing fields are ours; D1 selects the common-mode source the board set up
+    uint8_t pop_reduce;
+    BusGuard guard(this->bus_lock_());
+    const uint32_t start = micros();
+    bool result = this->write_byte(AIC3104_PAGE_CTRL, 0x00) &&
+                  this->read_byte(AIC3104_OUTPUT_POP_REDUCE, &pop_reduce) &&
+                  this->write_byte(AIC3104_OUTPUT_POP_REDUCE,
+                                   (pop_reduce & ~AIC3104_POP_REDUCE_TIMING_MASK) | this->pop_reduction_);
+    this->bus_record_(false, 2 * REG_WRITE_BUS_BYTES + REG_READ_BUS_BYTES, start);
+    ERROR_CHECK(result, "Writing pop reduction timing failed");
+    // Nothing is playing yet
+    this->idle();
+  }
+
+  if (this->diagnostics_enabled_()) {
+    // Flags latched before we started (e.g. while the XVF3800 brought the codec up) are
+    // read once and discarded so they don't show up as events.
+    uint8_t flags[2];
+    {
+      BusGuard guard(this->bus_lock_());
+      this->write_byte(AIC3104_PAGE_CTRL, 0x00);
+      this->read_bytes(AIC3104_OUTPUT_SCD_STATUS, flags, sizeof(flags));
+      this->read_byte(AIC3104_OVRF_STATUS_PLL_R, flags);
+    }
+
+    if (this->dac_overflow_count_sensor_ != nullptr) {
+      this->dac_overflow_count_sensor_->publish_state(0);
+    }
+    if (this->short_circuit_count_sensor_ != nullptr) {
+      this->short_circuit_count_sensor_->publish_state(0);
+    }
+    this->diagnostics_interval_ = this->diagnostics_max_interval_;
+    this->schedule_diagnostics_();
+  }
 }
 
 void AIC3104::dump_config() {
   ESP_LOGCONFIG(TAG, "AIC3104:");
   LOG_I2C_DEVICE(this);
+  if (this->sample_rate_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Sample rate: %" PRIu32 " Hz, %u bits per sample", this->sample_rate_,
+                  this->bits_per_sample_);
+    ESP_LOGCONFIG(TAG, "  MCLK frequency: %" PRIu32 " Hz", this->mclk_frequency_);
+  }
+  if (this->diagnostics_enabled_()) {
+    ESP_LOGCONFIG(TAG, "  Diagnostics interval: %" PRIu32 "-%" PRIu32 "ms", this->diagnostics_min_interval_,
+                  this->diagnostics_max_interval_);
+    LOG_BINARY_SENSOR("  ", "DAC Overflow", this->dac_overflow_binary_sensor_);
+    LOG_BINARY_SENSOR("  ", "Short Circuit", this->short_circuit_binary_sensor_);
+    LOG_SENSOR("  ", "DAC Overflow Count", this->dac_overflow_count_sensor_);
+    LOG_SENSOR("  ", "Short Circuit Count", this->short_circuit_count_sensor_);
+  }
+  if (this->idle_timeout_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Idle power-down after: %" PRIu32 "ms", this->idle_timeout_);
+    ESP_LOGCONFIG(TAG, "  Pop reduction: 0x%02X", this->pop_reduction_);
+    LOG_SENSOR("  ", "Wake Latency", this->wake_latency_sensor_);
+  }
 
   if (this->is_failed()) {
     ESP_LOGE(TAG, ESP_LOG_MSG_COMM_FAIL);
@@ -41,12 +176,38 @@ bool AIC3104::set_mute_on() {
 
 bool AIC3104::set_volume(float volume) {
   this->volume_ = clamp<float>(volume, 0.0, 1.0);
-  ESP_LOGD(TAG, "AIC3104 set_volume called: %.2f", this->volume_);
+  ESP_LOGV(TAG, "AIC3104 set_volume called: %.2f", this->volume_);
   bool result = this->write_volume_();
-  ESP_LOGD(TAG, "AIC3104 write_volume result: %s", result ? "SUCCESS" : "FAILED");
+  ESP_LOGV(TAG, "AIC3104 write_volume result: %s", result ? "SUCCESS" : "FAILED");
   return result;
 }
 
+bool AIC3104::set_sample_rate(uint32_t sample_rate) {
+  if (sample_rate == this->sample_rate_) {
+    return true;
+  }
+
+  // Hold the DAC at mute while the clock tree changes, then restore the current volume/mute state
+  bool muted;
+  {
+    BusGuard guard(this->bus_lock_());
+    const uint32_t start = micros();
+    muted = this->write_byte(AIC3104_PAGE_CTRL, 0x00) && this->write_byte(AIC3104_LEFT_DAC_VOLUME, 0x80) &&
+            this->write_byte(AIC3104_RIGHT_DAC_VOLUME, 0x80);
+    this->bus_record_(false, 3 * REG_WRITE_BUS_BYTES, start);
+  }
+  if (!muted) {
+    ESP_LOGE(TAG, "Muting DAC before sample rate change failed");
+    return false;
+  }
+  bool result = this->write_clocks_(sample_rate);
+  if (result) {
+    this->sample_rate_ = sample_rate;
+    ESP_LOGD(TAG, "Sample rate set to %" PRIu32 " Hz", sample_rate);
+  }
+  return this->write_mute_() && result;
+}
+
 bool AIC3104::is_muted() { return this->is_muted_; }
 
 float AIC3104::volume() { return this->volume_; }
@@ -55,9 +216,13 @@ bool AIC3104::write_mute_() {
   // XVF3800/AIC3104 mute control - setting volume to maximum attenuation
   uint8_t mute_value = this->is_muted_ ? 0x80 : ((1.0f - this->volume_) * 0x80);
   
-  if (!this->write_byte(AIC3104_PAGE_CTRL, 0x00) || 
-      !this->write_byte(AIC3104_LEFT_DAC_VOLUME, mute_value) ||
-      !this->write_byte(AIC3104_RIGHT_DAC_VOLUME, mute_value)) {
+  BusGuard guard(this->bus_lock_());
+  const uint32_t start = micros();
+  bool result = this->write_byte(AIC3104_PAGE_CTRL, 0x00) &&
+                this->write_byte(AIC3104_LEFT_DAC_VOLUME, mute_value) &&
+                this->write_byte(AIC3104_RIGHT_DAC_VOLUME, mute_value);
+  this->bus_record_(false, 3 * REG_WRITE_BUS_BYTES, start);
+  if (!result) {
     ESP_LOGE(TAG, "Writing mute failed");
     return false;
   }
@@ -67,32 +232,295 @@ bool AIC3104::write_mute_() {
 }
 
 bool AIC3104::write_volume_() {
-  ESP_LOGD(TAG, "write_volume_() called - volume: %.2f", this->volume_);
+  ESP_LOGV(TAG, "write_volume_() called - volume: %.2f", this->volume_);
   
+  BusGuard guard(this->bus_lock_());
+  const uint32_t start = micros();
   if (!this->write_byte(AIC3104_PAGE_CTRL, 0x00)) {
+    this->bus_record_(false, REG_WRITE_BUS_BYTES, start);
     ESP_LOGE(TAG, "Failed to set page 0");
     return false;
   }
   
-  // Map volume 0.0-1.0 to DAC range 0x80-0x00 (inverted)
-  // 0x00 = 0dB (loudest), 0x7F = -63.5dB (quietest), 0x80 = mute
-  uint8_t dac_val = (uint8_t)((1.0f - this->volume_) * 0x80);
-  dac_val = clamp<uint8_t>(dac_val, 0x00, 0x80);
+  uint8_t dac_val = volume_to_dac(this->volume_);
   
-  ESP_LOGD(TAG, "Writing DAC volume: 0x%.2x (%.1fdB attenuation) to registers 0x2B/0x2C", 
+  ESP_LOGV(TAG, "Writing DAC volume: 0x%.2x (%.1fdB attenuation) to registers 0x2B/0x2C", 
            dac_val, -(float)dac_val);
   
-  if (!this->write_byte(AIC3104_LEFT_DAC_VOLUME, dac_val) ||
-      !this->write_byte(AIC3104_RIGHT_DAC_VOLUME, dac_val)) {
+  bool result = this->write_byte(AIC3104_LEFT_DAC_VOLUME, dac_val) && this->write_byte(AIC3104_RIGHT_DAC_VOLUME, dac_val);
+  this->bus_record_(false, 3 * REG_WRITE_BUS_BYTES, start);
+#ifdef USE_AIC3104_BUS_SCHEDULER
+  if (this->trace_ != nullptr) {
+    this->trace_->record(respeaker_xvf3800::TRACE_DAC_VOLUME, dac_val, AIC3104_LEFT_DAC_VOLUME, !result,
+                         micros() - start, this->volume_);
+  }
+#endif
+  if (!result) {
     ESP_LOGE(TAG, "Writing DAC volume failed");
     return false;
   }
   
-  ESP_LOGD(TAG, "Volume %.1f%% → DAC: 0x%.2x (%.1fdB attenuation) - SUCCESS", 
+  ESP_LOGV(TAG, "Volume %.1f%% → DAC: 0x%.2x (%.1fdB attenuation) - SUCCESS", 
            this->volume_ * 100.0f, dac_val, -(float)dac_val);
   
   return true;
 }
 
+bool AIC3104::write_clocks_(uint32_t sample_rate) {
+  uint32_t fsref;
+  uint8_t divider;
+  if (!compute_sample_rate_divider(sample_rate, fsref, divider)) {
+    ESP_LOGE(TAG, "Unsupported sample rate: %" PRIu32 " Hz", sample_rate);
+    return false;
+  }
+
+  ClockConfig clk;
+  if (!compute_clock_config(this->mclk_frequency_, fsref, clk)) {
+    ESP_LOGE(TAG, "Can't derive %" PRIu32 " Hz from %" PRIu32 " Hz MCLK", fsref, this->mclk_frequency_);
+    return false;
+  }
+
+  uint8_t word_length;
+  switch (this->bits_per_sample_) {
+    case 16:
+      word_length = 0x00;
+      break;
+    case 20:
+      word_length = 0x01;
+      break;
+    case 24:
+      word_length = 0x02;
+      break;
+    default:
+      word_length = 0x03;
+      break;
+  }
+
+  // Q = 16/17 and P = 8 wrap to 0/1 and 0 in their register fields; R = 16 wraps to 0
+  const uint8_t pll_q_p = clk.use_pll ? (AIC3104_PLL_ENABLE | (clk.p & 0x07)) : ((clk.q & 0x0F) << 3);
+  uint8_t dac_power;
+
+  // Serial interface stays in slave mode (register 8 = 0): the XVF3800 drives BCLK and WCLK.
+  BusGuard guard(this->bus_lock_());
+  const uint32_t start = micros();
+  bool result =
+      this->write_byte(AIC3104_PAGE_CTRL, 0x00) && this->write_byte(AIC3104_CLOCK_GEN_CTRL, AIC3104_CLOCK_GEN_MCLK) &&
+      this->write_byte(AIC3104_PLL_Q_P, pll_q_p) && this->write_byte(AIC3104_PLL_J, clk.j << 2) &&
+      this->write_byte(AIC3104_PLL_D_MSB, clk.d >> 6) && this->write_byte(AIC3104_PLL_D_LSB, (clk.d & 0x3F) << 2) &&
+      this->write_byte(AIC3104_OVRF_STATUS_PLL_R, clk.r & 0x0F) &&
+      this->write_byte(AIC3104_CLOCK_REG, clk.use_pll ? 0x00 : AIC3104_CODEC_CLKIN_CLKDIV) &&
+      this->write_byte(AIC3104_CODEC_SR_SEL, (divider << 4) | divider) &&
+      this->write_byte(AIC3104_CODEC_DATA_PATH,
+                       (fsref == 44100 ? AIC3104_DATA_PATH_FSREF_44_1K : 0x00) | AIC3104_DATA_PATH_DAC_LR) &&
+      this->write_byte(AIC3104_ASD_IF_CTRL_A, 0x00) && this->write_byte(AIC3104_ASD_IF_CTRL_B, word_length << 4) &&
+      this->write_byte(AIC3104_ASD_IF_CTRL_C, 0x00) && this->read_byte(AIC3104_DAC_POWER_OUTPUT, &dac_power) &&
+      this->write_byte(AIC3104_DAC_POWER_OUTPUT,
+                       this->power_state_ == POWER_DOWN ? dac_power : (dac_power | AIC3104_DAC_POWER_LR));
+  this->bus_record_(false, 14 * REG_WRITE_BUS_BYTES + REG_READ_BUS_BYTES, start);
+  if (!result) {
+    ESP_LOGE(TAG, "Writing clock configuration failed");
+    return false;
+  }
+
+  if (clk.use_pll) {
+    ESP_LOGV(TAG, "PLL: P=%u R=%u J=%u D=%u for fsref %" PRIu32 " Hz", clk.p, clk.r, clk.j, clk.d, fsref);
+  } else {
+    ESP_LOGV(TAG, "Clock divider: Q=%u for fsref %" PRIu32 " Hz", clk.q, fsref);
+  }
+  return true;
+}
+
+void AIC3104::wake() {
+  if (this->idle_timeout_ == 0) {
+    return;
+  }
+  this->cancel_timeout("idle_power_down");
+  if (this->power_state_ == POWER_DOWN) {
+    this->power_up_();
+  }
+}
+
+void AIC3104::idle() {
+  if (this->idle_timeout_ == 0 || this->power_state_ == POWER_DOWN) {
+    return;
+  }
+  this->set_timeout("idle_power_down", this->idle_timeout_, [this]() { this->power_down_(); });
+}
+
+bool AIC3104::power_down_() {
+  if (this->power_state_ == POWER_WAKING) {
+    this->cancel_interval("wake_poll");
+  }
+
+  uint8_t dac_power;
+  uint8_t levels[NUM_OUTPUTS];
+  BusGuard guard(this->bus_lock_());
+  const uint32_t start = micros();
+  bool result = this->write_byte(AIC3104_PAGE_CTRL, 0x00) && this->read_byte(AIC3104_DAC_POWER_OUTPUT, &dac_power);
+  for (size_t i = 0; result && i < NUM_OUTPUTS; i++) {
+    result = this->read_byte(OUTPUT_LEVEL_REGISTERS[i], &levels[i]);
+  }
+  size_t writes = 1;
+  uint8_t powered = 0;
+  uint8_t status_mask = dac_power & AIC3104_DAC_POWER_LR;
+  // Drivers go first so they ramp down (register 42 timing) before the DAC stops driving them
+  for (size_t i = 0; result && i < NUM_OUTPUTS; i++) {
+    if ((levels[i] & AIC3104_OUTPUT_POWER_ON) == 0) {
+      continue;
+    }
+    powered |= 1 << i;
+    status_mask |= 1 << (NUM_OUTPUTS - 1 - i);
+    result = this->write_byte(OUTPUT_LEVEL_REGISTERS[i], levels[i] & ~AIC3104_OUTPUT_POWER_ON);
+    writes++;
+  }
+  if (result && (dac_power & AIC3104_DAC_POWER_LR) != 0) {
+    result = this->write_byte(AIC3104_DAC_POWER_OUTPUT, dac_power & ~AIC3104_DAC_POWER_LR);
+    writes++;
+  }
+  this->bus_record_(false, writes * REG_WRITE_BUS_BYTES + (1 + NUM_OUTPUTS) * REG_READ_BUS_BYTES, start);
+  if (!result) {
+    // Some stages may be down already; wake() restores them from what was saved last time
+    ESP_LOGW(TAG, "Powering down outputs failed");
+    this->power_state_ = POWER_ON;
+    return false;
+  }
+
+  this->saved_dac_power_ = dac_power;
+  memcpy(this->saved_output_levels_, levels, sizeof(levels));
+  this->powered_outputs_ = powered;
+  this->wake_status_mask_ = status_mask;
+  this->power_state_ = POWER_DOWN;
+  ESP_LOGD(TAG, "Idle: DAC and outputs powered down (outputs 0x%02X)", powered);
+  return true;
+}
+
+bool AIC3104::power_up_() {
+  // Cached values only, no read-modify-write: the whole wake is one run of writes
+  BusGuard guard(this->bus_lock_());
+  this->wake_start_us_ = micros();
+  bool result = this->write_byte(AIC3104_PAGE_CTRL, 0x00) &&
+                this->write_byte(AIC3104_DAC_POWER_OUTPUT, this->saved_dac_power_);
+  size_t writes = 2;
+  for (size_t i = 0; result && i < NUM_OUTPUTS; i++) {
+    if ((this->powered_outputs_ & (1 << i)) != 0) {
+      result = this->write_byte(OUTPUT_LEVEL_REGISTERS[i], this->saved_output_levels_[i]);
+      writes++;
+    }
+  }
+  this->bus_record_(false, writes * REG_WRITE_BUS_BYTES, this->wake_start_us_);
+  if (!result) {
+    ESP_LOGE(TAG, "Powering up outputs failed");
+    return false;  // still POWER_DOWN, the next wake() retries
+  }
+
+  this->power_state_ = POWER_WAKING;
+  this->set_interval("wake_poll", 1, [this]() { this->poll_wake_(); });
+  return true;
+}
+
+void AIC3104::poll_wake_() {
+  uint8_t status = 0;
+  BusGuard guard(this->bus_lock_());
+  const uint32_t start = micros();
+  bool result = this->read_byte(AIC3104_MODULE_POWER_STATUS, &status);
+  this->bus_record_(false, REG_READ_BUS_BYTES, start);
+  const uint32_t elapsed = micros() - this->wake_start_us_;
+  const bool ready = result && (status & this->wake_status_mask_) == this->wake_status_mask_;
+  if (!ready && elapsed < WAKE_TIMEOUT_US) {
+    return;
+  }
+
+  this->cancel_interval("wake_poll");
+  this->power_state_ = POWER_ON;
+  if (!ready) {
+    ESP_LOGW(TAG, "Outputs not reported up after %" PRIu32 "ms (status 0x%02X)", elapsed / 1000, status);
+    return;
+  }
+  ESP_LOGD(TAG, "Woke in %.1fms", elapsed / 1000.0f);
+  if (this->wake_latency_sensor_ != nullptr) {
+    this->wake_latency_sensor_->publish_state(elapsed / 1000.0f);
+  }
+}
+
+void AIC3104::schedule_diagnostics_() {
+  this->set_timeout("diagnostics", this->diagnostics_interval_, [this]() {
+    if (this->poll_diagnostics_()) {
+      this->diagnostics_interval_ = this->diagnostics_min_interval_;
+    } else {
+      this->diagnostics_interval_ = std::min(this->diagnostics_interval_ * 2, this->diagnostics_max_interval_);
+    }
+    this->schedule_diagnostics_();
+  });
+}
+
+// Returns true if any event was latched since the previous poll.
+bool AIC3104::poll_diagnostics_() {
+  // Registers 95 (short-circuit status) and 96 (sticky flags) are adjacent, so they are
+  // fetched with one auto-incrementing read; register 11 only needs its overflow bits.
+  const size_t bus_bytes = REG_WRITE_BUS_BYTES + REG_READ_BUS_BYTES + 1 + REG_READ_BUS_BYTES;
+  if (!this->bus_admit_telemetry_(bus_bytes)) {
+    return false;
+  }
+
+  uint8_t scd_flags[2];
+  uint8_t ovrf;
+  BusGuard guard(this->bus_lock_());
+  const uint32_t start = micros();
+  bool result = this->write_byte(AIC3104_PAGE_CTRL, 0x00) &&
+                this->read_bytes(AIC3104_OUTPUT_SCD_STATUS, scd_flags, sizeof(scd_flags)) &&
+                this->read_byte(AIC3104_OVRF_STATUS_PLL_R, &ovrf);
+  this->bus_record_(true, bus_bytes, start);
+  if (!result) {
+    ESP_LOGW(TAG, "Reading diagnostic flags failed");
+    return false;
+  }
+
+  const bool dac_overflow = (ovrf & AIC3104_OVRF_DAC_MASK) != 0;
+  const bool short_circuit_latched = (scd_flags[1] & AIC3104_SCD_MASK) != 0;
+  const bool short_circuit = short_circuit_latched || (scd_flags[0] & AIC3104_SCD_MASK) != 0;
+
+  if (dac_overflow) {
+    this->dac_overflow_count_++;
+    ESP_LOGW(TAG, "DAC overflow (clipping) detected: flags=0x%02X", ovrf);
+    if (this->dac_overflow_count_sensor_ != nullptr) {
+      this->dac_overflow_count_sensor_->publish_state(this->dac_overflow_count_);
+    }
+  }
+  if (short_circuit_latched) {
+    this->short_circuit_count_++;
+    ESP_LOGW(TAG, "Output short circuit detected: status=0x%02X, sticky=0x%02X", scd_flags[0], scd_flags[1]);
+    if (this->short_circuit_count_sensor_ != nullptr) {
+      this->short_circuit_count_sensor_->publish_state(this->short_circuit_count_);
+    }
+  }
+
+  if (this->dac_overflow_binary_sensor_ != nullptr) {
+    this->dac_overflow_binary_sensor_->publish_state(dac_overflow);
+  }
+  if (this->short_circuit_binary_sensor_ != nullptr) {
+    this->short_circuit_binary_sensor_->publish_state(short_circuit);
+  }
+
+  return dac_overflow || short_circuit;
+}
+
+bool AIC3104::bus_admit_telemetry_(size_t bytes) {
+#ifdef USE_AIC3104_BUS_SCHEDULER
+  if (this->bus_scheduler_ != nullptr) {
+    return this->bus_scheduler_->admit(respeaker_xvf3800::BUS_CLASS_TELEMETRY, bytes);
+  }
+#endif
+  return true;
+}
+
+void AIC3104::bus_record_(bool telemetry, size_t bytes, uint32_t start_us) {
+#ifdef USE_AIC3104_BUS_SCHEDULER
+  if (this->bus_scheduler_ != nullptr) {
+    this->bus_scheduler_->record(telemetry ? respeaker_xvf3800::BUS_CLASS_TELEMETRY : respeaker_xvf3800::BUS_CLASS_AUDIO,
+                                 bytes, micros() - start_us);
+  }
+#endif
+}
+
 }  // namespace aic3104
 }  // namespace esphome
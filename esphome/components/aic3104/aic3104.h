@@ -1,10 +1,18 @@
 #pragma once
 
 #include "esphome/components/audio_dac/audio_dac.h"
+#include "esphome/components/binary_sensor/binary_sensor.h"
 #include "esphome/components/i2c/i2c.h"
+#include "esphome/components/sensor/sensor.h"
 #include "esphome/core/component.h"
 #include "esphome/core/defines.h"
 #include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "dac_volume.h"
+#ifdef USE_AIC3104_BUS_SCHEDULER
+#include "esphome/components/respeaker_xvf3800/bus_scheduler.h"
+#include "esphome/components/respeaker_xvf3800/trace.h"
+#endif
 
 namespace esphome {
 namespace aic3104 {
@@ -97,11 +105,88 @@ namespace aic3104 {
 #define AIC3104_PASSIVE_BYPASS          0x6C // Register 108: Passive Analog Signal Bypass Selection During Power Down Register
 #define AIC3104_DAC_QUIESCENT_CUR       0x6D // Register 109: DAC Quiescent Current Adjustment Register
 
+// Register 11 (overflow flags, sticky - cleared on read)
+static const uint8_t AIC3104_OVRF_LEFT_ADC = 0x80;
+static const uint8_t AIC3104_OVRF_RIGHT_ADC = 0x40;
+static const uint8_t AIC3104_OVRF_LEFT_DAC = 0x20;
+static const uint8_t AIC3104_OVRF_RIGHT_DAC = 0x10;
+static const uint8_t AIC3104_OVRF_DAC_MASK = AIC3104_OVRF_LEFT_DAC | AIC3104_OVRF_RIGHT_DAC;
+// Registers 95/96 (short-circuit status / sticky flags): HPLOUT, HPROUT, HPLCOM, HPRCOM in D7..D4
+static const uint8_t AIC3104_SCD_MASK = 0xF0;
+
+// Register 3: PLL enable, Q (D6-D3) and P (D2-D0, 0 = 8)
+static const uint8_t AIC3104_PLL_ENABLE = 0x80;
+// Register 7: fsref select and DAC data paths (left DAC <- left channel, right DAC <- right channel)
+static const uint8_t AIC3104_DATA_PATH_FSREF_44_1K = 0x80;
+static const uint8_t AIC3104_DATA_PATH_DAC_LR = 0x0A;
+// Register 37: DAC power
+static const uint8_t AIC3104_DAC_POWER_LR = 0xC0;
+// Register 42: output driver power-on delay (D7-D4) and ramp-up step time (D3-D2)
+static const uint8_t AIC3104_POP_REDUCE_TIMING_MASK = 0xFC;
+// Output level registers 51/58/65/72/86/93: D0 set = driver fully powered up
+static const uint8_t AIC3104_OUTPUT_POWER_ON = 0x01;
+// Register 101: CODEC_CLKIN source (0 = PLLDIV_OUT, 1 = CLKDIV_OUT)
+static const uint8_t AIC3104_CODEC_CLKIN_CLKDIV = 0x01;
+// Register 102: CLKDIV_IN and PLLCLK_IN both from MCLK
+static const uint8_t AIC3104_CLOCK_GEN_MCLK = 0x02;
+
+static const uint32_t AIC3104_DEFAULT_MCLK_FREQUENCY = 12288000;
+
 class AIC3104 : public audio_dac::AudioDac, public Component, public i2c::I2CDevice {
  public:
   void setup() override;
   void dump_config() override;
 
+  // Diagnostics: poll the sticky flag registers. The interval starts at min_interval
+  // after an event and doubles on every quiet poll up to max_interval.
+  void set_diagnostics_interval(uint32_t min_interval, uint32_t max_interval) {
+    this->diagnostics_min_interval_ = min_interval;
+    this->diagnostics_max_interval_ = max_interval;
+  }
+  void set_dac_overflow_binary_sensor(binary_sensor::BinarySensor *sensor) { this->dac_overflow_binary_sensor_ = sensor; }
+  void set_short_circuit_binary_sensor(binary_sensor::BinarySensor *sensor) {
+    this->short_circuit_binary_sensor_ = sensor;
+  }
+  void set_dac_overflow_count_sensor(sensor::Sensor *sensor) { this->dac_overflow_count_sensor_ = sensor; }
+  void set_short_circuit_count_sensor(sensor::Sensor *sensor) { this->short_circuit_count_sensor_ = sensor; }
+
+  uint32_t get_dac_overflow_count() const { return this->dac_overflow_count_; }
+  uint32_t get_short_circuit_count() const { return this->short_circuit_count_; }
+
+  // Clocking: when a sample rate is set the driver programs the PLL, sample-rate select,
+  // data path and serial interface itself instead of relying on the XVF3800's setup.
+  void set_mclk_frequency(uint32_t mclk_frequency) { this->mclk_frequency_ = mclk_frequency; }
+  void set_initial_sample_rate(uint32_t sample_rate) { this->sample_rate_ = sample_rate; }
+  void set_bits_per_sample(uint8_t bits_per_sample) { this->bits_per_sample_ = bits_per_sample; }
+
+  // Switches the codec to a new sample rate at runtime. The DAC is muted while the
+  // clock tree is reprogrammed. Returns false if the rate can't be derived from MCLK.
+  bool set_sample_rate(uint32_t sample_rate);
+
+#ifdef USE_AIC3104_BUS_SCHEDULER
+  // Shares the XVF3800 hub's bus scheduler: volume/clock writes are accounted as
+  // audio traffic, diagnostic polls as telemetry (and skipped when over budget).
+  void set_bus_scheduler(respeaker_xvf3800::BusScheduler *bus_scheduler) { this->bus_scheduler_ = bus_scheduler; }
+  // Volume writes go to the hub's trace buffer when it has one
+  void set_trace(respeaker_xvf3800::TraceBuffer *trace) { this->trace_ = trace; }
+  // Register access holds the hub's transport lock, so it never interleaves with transfers
+  // of the XVF3800 control task on the shared bus
+  void set_transport_lock(Mutex *transport_lock) { this->transport_lock_ = transport_lock; }
+#endif
+  uint32_t get_sample_rate() const { return this->sample_rate_; }
+
+  // Idle power-down: idle() starts the silence timer, after which the output drivers and
+  // the DAC are powered down. wake() brings them back with one burst of cached register
+  // writes; the drivers then ramp up using the register 42 pop-reduction timing.
+  void set_idle_timeout(uint32_t timeout) { this->idle_timeout_ = timeout; }
+  void set_pop_reduction(uint8_t power_on_delay, uint8_t ramp_step) {
+    this->pop_reduction_ = (power_on_delay << 4) | (ramp_step << 2);
+  }
+  void set_wake_latency_sensor(sensor::Sensor *sensor) { this->wake_latency_sensor_ = sensor; }
+  void wake();
+  void idle();
+  bool is_powered_down() const { return this->power_state_ != POWER_ON; }
+
   bool set_mute_off() override;
   bool set_mute_on() override;
   bool set_volume(float volume) override;
@@ -112,8 +197,83 @@ class AIC3104 : public audio_dac::AudioDac, public Component, public i2c::I2CDev
  protected:
   bool write_mute_();
   bool write_volume_();
+  bool write_clocks_(uint32_t sample_rate);
+
+  // Locks the shared transport (if any) for the lifetime of the guard
+  class BusGuard {
+   public:
+    explicit BusGuard(Mutex *lock) : lock_(lock) {
+      if (this->lock_ != nullptr) {
+        this->lock_->lock();
+      }
+    }
+    ~BusGuard() {
+      if (this->lock_ != nullptr) {
+        this->lock_->unlock();
+      }
+    }
+
+   protected:
+    Mutex *lock_;
+  };
+  Mutex *bus_lock_() const {
+#ifdef USE_AIC3104_BUS_SCHEDULER
+    return this->transport_lock_;
+#else
+    return nullptr;
+#endif
+  }
+
+  bool bus_admit_telemetry_(size_t bytes);
+  void bus_record_(bool telemetry, size_t bytes, uint32_t start_us);
+
+  enum PowerState : uint8_t {
+    POWER_ON,
+    POWER_DOWN,
+    POWER_WAKING,  // burst written, waiting for register 94 to report the stages up
+  };
+
+  bool power_down_();
+  bool power_up_();
+  void poll_wake_();
+
+  bool diagnostics_enabled_() const { return this->diagnostics_max_interval_ != 0; }
+  void schedule_diagnostics_();
+  bool poll_diagnostics_();
 
   float volume_{0};
+
+  uint32_t mclk_frequency_{AIC3104_DEFAULT_MCLK_FREQUENCY};
+  uint32_t sample_rate_{0};
+  uint8_t bits_per_sample_{32};
+
+  uint32_t diagnostics_min_interval_{0};
+  uint32_t diagnostics_max_interval_{0};
+  uint32_t diagnostics_interval_{0};
+  uint32_t dac_overflow_count_{0};
+  uint32_t short_circuit_count_{0};
+
+  uint32_t idle_timeout_{0};
+  uint8_t pop_reduction_{0};
+  PowerState power_state_{POWER_ON};
+  // Register values from before the power-down, restored verbatim on wake
+  uint8_t saved_dac_power_{0};
+  uint8_t saved_output_levels_[6]{};
+  uint8_t powered_outputs_{0};  // bit i: output level register i was powered up
+  uint8_t wake_status_mask_{0};  // register 94 bits expected once everything is back up
+  uint32_t wake_start_us_{0};
+  sensor::Sensor *wake_latency_sensor_{nullptr};
+
+  binary_sensor::BinarySensor *dac_overflow_binary_sensor_{nullptr};
+  binary_sensor::BinarySensor *short_circuit_binary_sensor_{nullptr};
+  sensor::Sensor *dac_overflow_count_sensor_{nullptr};
+  sensor::Sensor *short_circuit_count_sensor_{nullptr};
+
+#ifdef USE_AIC3104_BUS_SCHEDULER
+  respeaker_xvf3800::BusScheduler *bus_scheduler_{nullptr};
+  respeaker_xvf3800::TraceBuffer *trace_{nullptr};
+  Mutex *transport_lock_{nullptr};
+#endif
 };
 
 }  // namespace aic3104
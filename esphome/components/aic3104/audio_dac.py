@@ -1,27 +1,230 @@
 from esphome import automation
 import esphome.codegen as cg
-from esphome.components import i2c
+from esphome.components import binary_sensor, i2c, sensor
 from esphome.components.audio_dac import AudioDac
 import esphome.config_validation as cv
-from esphome.const import CONF_ID
+from esphome.const import (
+    CONF_ID,
+    CONF_MAX_INTERVAL,
+    CONF_MIN_INTERVAL,
+    CONF_SAMPLE_RATE,
+    CONF_TIMEOUT,
+    DEVICE_CLASS_DURATION,
+    DEVICE_CLASS_PROBLEM,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
+    UNIT_MILLISECOND,
+)
 
 CODEOWNERS = ["@formatBCE"]
 DEPENDENCIES = ["i2c"]
+AUTO_LOAD = ["binary_sensor", "sensor"]
+
+CONF_DIAGNOSTICS = "diagnostics"
+CONF_DAC_OVERFLOW = "dac_overflow"
+CONF_DAC_OVERFLOW_COUNT = "dac_overflow_count"
+CONF_SHORT_CIRCUIT = "short_circuit"
+CONF_SHORT_CIRCUIT_COUNT = "short_circuit_count"
+CONF_BITS_PER_SAMPLE = "bits_per_sample"
+CONF_MCLK_FREQUENCY = "mclk_frequency"
+CONF_RESPEAKER_XVF3800_ID = "respeaker_xvf3800_id"
+CONF_IDLE_POWER_DOWN = "idle_power_down"
+CONF_POWER_ON_DELAY = "power_on_delay"
+CONF_RAMP_STEP = "ramp_step"
+CONF_WAKE_LATENCY = "wake_latency"
+
+# Rates reachable from a 48 kHz or 44.1 kHz fsref via the codec sample-rate divider
+SAMPLE_RATES = [8000, 11025, 12000, 16000, 22050, 24000, 32000, 44100, 48000]
 
 aic3104_ns = cg.esphome_ns.namespace("aic3104")
 AIC3104 = aic3104_ns.class_("AIC3104", AudioDac, cg.Component, i2c.I2CDevice)
+# Declared here rather than imported so the DAC also works without the hub component
+RespeakerXVF3800 = cg.esphome_ns.namespace("respeaker_xvf3800").class_(
+    "RespeakerXVF3800", cg.Component, i2c.I2CDevice
+)
+SetSampleRateAction = aic3104_ns.class_("SetSampleRateAction", automation.Action)
+WakeAction = aic3104_ns.class_("WakeAction", automation.Action)
+IdleAction = aic3104_ns.class_("IdleAction", automation.Action)
+
+# Register 42 field codes: output driver power-on delay and ramp-up step time
+POWER_ON_DELAYS = {
+    "0us": 0,
+    "10us": 1,
+    "100us": 2,
+    "1ms": 3,
+    "10ms": 4,
+    "50ms": 5,
+    "100ms": 6,
+    "200ms": 7,
+    "400ms": 8,
+    "800ms": 9,
+    "2s": 10,
+    "4s": 11,
+}
+RAMP_STEPS = {"0ms": 0, "1ms": 1, "2ms": 2, "4ms": 3}
+
+
+def _validate_diagnostics(config):
+    if config[CONF_MIN_INTERVAL] > config[CONF_MAX_INTERVAL]:
+        raise cv.Invalid(f"{CONF_MIN_INTERVAL} must not be greater than {CONF_MAX_INTERVAL}")
+    return config
+
+
+DIAGNOSTICS_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_MIN_INTERVAL, default="1s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_MAX_INTERVAL, default="30s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_DAC_OVERFLOW): binary_sensor.binary_sensor_schema(
+                device_class=DEVICE_CLASS_PROBLEM,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                icon="mdi:waveform",
+            ),
+            cv.Optional(CONF_SHORT_CIRCUIT): binary_sensor.binary_sensor_schema(
+                device_class=DEVICE_CLASS_PROBLEM,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                icon="mdi:flash-alert",
+            ),
+            cv.Optional(CONF_DAC_OVERFLOW_COUNT): sensor.sensor_schema(
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_TOTAL_INCREASING,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                icon="mdi:counter",
+            ),
+            cv.Optional(CONF_SHORT_CIRCUIT_COUNT): sensor.sensor_schema(
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_TOTAL_INCREASING,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                icon="mdi:counter",
+            ),
+        }
+    ),
+    _validate_diagnostics,
+)
+
+IDLE_POWER_DOWN_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_TIMEOUT, default="30s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_POWER_ON_DELAY, default="10ms"): cv.enum(POWER_ON_DELAYS, lower=True),
+        cv.Optional(CONF_RAMP_STEP, default="1ms"): cv.enum(RAMP_STEPS, lower=True),
+        cv.Optional(CONF_WAKE_LATENCY): sensor.sensor_schema(
+            unit_of_measurement=UNIT_MILLISECOND,
+            accuracy_decimals=1,
+            device_class=DEVICE_CLASS_DURATION,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            icon="mdi:timer-play-outline",
+        ),
+    }
+)
 
 CONFIG_SCHEMA = (
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(AIC3104),
+            cv.Optional(CONF_DIAGNOSTICS): DIAGNOSTICS_SCHEMA,
+            cv.Optional(CONF_IDLE_POWER_DOWN): IDLE_POWER_DOWN_SCHEMA,
+            cv.Optional(CONF_SAMPLE_RATE): cv.one_of(*SAMPLE_RATES, int=True),
+            cv.Optional(CONF_BITS_PER_SAMPLE, default="32bit"): cv.All(
+                cv.float_with_unit("Bits per sample", "bit"), cv.int_, cv.one_of(16, 20, 24, 32)
+            ),
+            cv.Optional(CONF_MCLK_FREQUENCY, default="12.288MHz"): cv.frequency,
+            cv.Optional(CONF_RESPEAKER_XVF3800_ID): cv.use_id(RespeakerXVF3800),
         }
     )
     .extend(cv.COMPONENT_SCHEMA)
     .extend(i2c.i2c_device_schema(0x18))
 )
 
+
+@automation.register_action(
+    "aic3104.set_sample_rate",
+    SetSampleRateAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(AIC3104),
+            cv.Required(CONF_SAMPLE_RATE): cv.templatable(cv.one_of(*SAMPLE_RATES, int=True)),
+        }
+    ),
+)
+async def aic3104_set_sample_rate_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+    template_ = await cg.templatable(config[CONF_SAMPLE_RATE], args, cg.uint32)
+    cg.add(var.set_sample_rate(template_))
+    return var
+
+
+AIC3104_ACTION_SCHEMA = automation.maybe_simple_id({cv.GenerateID(): cv.use_id(AIC3104)})
+
+
+# Playback is about to start: power the outputs back up if they idled down
+@automation.register_action("aic3104.wake", WakeAction, AIC3104_ACTION_SCHEMA)
+# Playback stopped: start the idle power-down timer
+@automation.register_action("aic3104.idle", IdleAction, AIC3104_ACTION_SCHEMA)
+async def aic3104_power_action_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    return cg.new_Pvariable(action_id, template_arg, paren)
+
+
 async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
     await i2c.register_i2c_device(var, config)
+
+    if CONF_RESPEAKER_XVF3800_ID in config:
+        hub = await cg.get_variable(config[CONF_RESPEAKER_XVF3800_ID])
+        cg.add(var.set_bus_scheduler(hub.get_bus_scheduler()))
+        cg.add(var.set_trace(hub.get_trace()))
+        cg.add(var.set_transport_lock(hub.get_transport_lock()))
+        cg.add_define("USE_AIC3104_BUS_SCHEDULER")
+
+    # Without a sample rate the codec is left as the XVF3800 configured it
+    if CONF_SAMPLE_RATE in config:
+        cg.add(var.set_initial_sample_rate(config[CONF_SAMPLE_RATE]))
+        cg.add(var.set_bits_per_sample(config[CONF_BITS_PER_SAMPLE]))
+        cg.add(var.set_mclk_frequency(int(config[CONF_MCLK_FREQUENCY])))
+
+    if diag_config := config.get(CONF_DIAGNOSTICS):
+        cg.add(
+            var.set_diagnostics_interval(
+                diag_config[CONF_MIN_INTERVAL], diag_config[CONF_MAX_INTERVAL]
+            )
+        )
+        if CONF_DAC_OVERFLOW in diag_config:
+            sens = await binary_sensor.new_binary_sensor(diag_config[CONF_DAC_OVERFLOW])
+            cg.add(var.set_dac_overflow_binary_sensor(sens))
+        if CONF_SHORT_CIRCUIT in diag_config:
+            sens = await binary_sensor.new_binary_sensor(diag_config[CONF_SHORT_CIRCUIT])
+            cg.add(var.set_short_circuit_binary_sensor(sens))
+        if CONF_DAC_OVERFLOW_COUNT in diag_config:
+            sens = await sensor.new_sensor(diag_config[CONF_DAC_OVERFLOW_COUNT])
+            cg.add(var.set_dac_overflow_count_sensor(sens))
+        if CONF_SHORT_CIRCUIT_COUNT in diag_config:
+            sens = await sensor.new_sensor(diag_config[CONF_SHORT_CIRCUIT_COUNT])
+            cg.add(var.set_short_circuit_count_sensor(sens))
+
+    if idle_config := config.get(CONF_IDLE_POWER_DOWN):
+        cg.add(var.set_idle_timeout(idle_config[CONF_TIMEOUT]))
+        cg.add(
+            var.set_pop_reduction(
+                idle_config[CONF_POWER_ON_DELAY], idle_config[CONF_RAMP_STEP]
+            )
+        )
+        if CONF_WAKE_LATENCY in idle_config:
+            sens = await sensor.new_sensor(idle_config[CONF_WAKE_LATENCY])
+            cg.add(var.set_wake_latency_sensor(sens))
+        # The AEC calibration probe plays straight to a speaker, past any media player
+        # automation that would wake the outputs
+        if CONF_RESPEAKER_XVF3800_ID in config:
+            hub = await cg.get_variable(config[CONF_RESPEAKER_XVF3800_ID])
+            cg.add(
+                hub.add_on_calibration_callback(
+                    cg.LambdaExpression(
+                        [f"if (active) {{ {var}->wake(); }} else {{ {var}->idle(); }}"],
+                        [(bool, "active")],
+                        capture="",
+                    )
+                )
+            )
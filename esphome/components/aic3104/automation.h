@@ -0,0 +1,41 @@
+#pragma once
+#include "aic3104.h"
+
+#include "esphome/core/automation.h"
+
+namespace esphome {
+namespace aic3104 {
+
+template<typename... Ts> class SetSampleRateAction : public Action<Ts...> {
+ public:
+  SetSampleRateAction(AIC3104 *parent) : parent_(parent) {}
+  TEMPLATABLE_VALUE(uint32_t, sample_rate)
+
+  void play(Ts... x) override { this->parent_->set_sample_rate(this->sample_rate_.value(x...)); }
+
+ protected:
+  AIC3104 *parent_;
+};
+
+template<typename... Ts> class WakeAction : public Action<Ts...> {
+ public:
+  WakeAction(AIC3104 *parent) : parent_(parent) {}
+
+  void play(Ts... x) override { this->parent_->wake(); }
+
+ protected:
+  AIC3104 *parent_;
+};
+
+template<typename... Ts> class IdleAction : public Action<Ts...> {
+ public:
+  IdleAction(AIC3104 *parent) : parent_(parent) {}
+
+  void play(Ts... x) override { this->parent_->idle(); }
+
+ protected:
+  AIC3104 *parent_;
+};
+
+}  // namespace aic3104
+}  // namespace esphome
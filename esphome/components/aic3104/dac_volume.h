@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+// No ESPHome dependencies: misc/hot_path_benchmark.cpp times the same code on a host.
+
+namespace esphome {
+namespace aic3104 {
+
+// Maps volume 0.0-1.0 to the DAC attenuation register (0x00 = 0dB ... 0x80 = mute)
+inline uint8_t volume_to_dac(float volume) {
+  // Map volume 0.0-1.0 to DAC range 0x80-0x00 (inverted)
+  // 0x00 = 0dB (loudest), 0x7F = -63.5dB (quietest), 0x80 = mute
+  uint8_t dac_val = (uint8_t) ((1.0f - volume) * 0x80);
+  return dac_val > 0x80 ? 0x80 : dac_val;
+}
+
+}  // namespace aic3104
+}  // namespace esphome
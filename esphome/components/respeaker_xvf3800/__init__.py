@@ -1,33 +1,149 @@
 import hashlib
 from pathlib import Path
+import struct
 import esphome.codegen as cg
 import esphome.config_validation as cv
-from esphome import automation, core, external_files
-from esphome.components import i2c, switch, text_sensor, sensor, number, select
+from esphome import automation, core, external_files, pins
+from esphome.components import i2c, switch, text_sensor, sensor, binary_sensor, number, select, speaker
+from esphome.components import time as time_, voice_assistant
 from esphome.const import (
+    CONF_BRIGHTNESS,
+    CONF_COLORS,
+    CONF_DURATION,
+    CONF_FREQUENCY,
     CONF_ID, 
+    CONF_INDEX,
+    CONF_MAX_VALUE,
+    CONF_MIN_VALUE,
+    CONF_NAME,
     CONF_ON_ERROR,
     CONF_RAW_DATA_ID,
+    CONF_RESET_PIN,
+    CONF_SAMPLE_RATE,
+    CONF_SENSOR,
+    CONF_SENSORS,
+    CONF_SIZE,
+    CONF_SOURCE,
+    CONF_SPEAKER,
+    CONF_THRESHOLD,
+    CONF_TIME_ID,
+    CONF_STEP,
     CONF_TRIGGER_ID,
+    CONF_TYPE,
+    CONF_UPDATE_INTERVAL,
     CONF_URL,
-    CONF_VERSION
+    CONF_VALUE,
+    CONF_VERSION,
+    DEVICE_CLASS_DURATION,
+    DEVICE_CLASS_SOUND,
+    ENTITY_CATEGORY_DIAGNOSTIC,
+    STATE_CLASS_MEASUREMENT,
+    UNIT_DECIBEL,
+    UNIT_MICROSECOND,
+    UNIT_PERCENT,
+    UNIT_SECOND,
 )
-from esphome.core import HexInt
+from esphome.core import CORE, HexInt
 
 # Dependency declarations
 DEPENDENCIES = ["i2c"]
-AUTO_LOAD = ["switch", "text_sensor", "sensor", "number", "select"]
+AUTO_LOAD = ["switch", "text_sensor", "sensor", "binary_sensor", "number", "select"]
 CODEOWNERS = ["@formatBCE"]
+MULTI_CONF = True
 
 # Configuration keys
 CONF_MUTE_SWITCH = "mute_switch"
 CONF_DFU_VERSION = "dfu_version"
 CONF_LED_BEAM_SENSOR = "led_beam_sensor"
+CONF_LED_RING = "led_ring"
+CONF_BEAM_LOCK = "beam_lock"
 CONF_FIRMWARE = "firmware"
 CONF_MD5 = "md5"
 CONF_ON_BEGIN = "on_begin"
 CONF_ON_END = "on_end"
 CONF_ON_PROGRESS = "on_progress"
+CONF_OUTPUT = "output"
+CONF_LEFT = "left"
+CONF_RIGHT = "right"
+CONF_CATEGORY = "category"
+CONF_WORD_FORMAT = "word_format"
+CONF_AEC_CALIBRATION = "aec_calibration"
+CONF_DWELL_TIME = "dwell_time"
+CONF_BUS_SCHEDULER = "bus_scheduler"
+CONF_BUDGETS = "budgets"
+CONF_UTILIZATION = "utilization"
+CONF_CONTROL_TASK = "control_task"
+CONF_TRACE = "trace"
+CONF_ACOUSTIC_PROFILES = "acoustic_profiles"
+CONF_PROFILES = "profiles"
+CONF_PROFILE = "profile"
+CONF_PARAMETERS = "parameters"
+CONF_RESID = "resid"
+CONF_CMD = "cmd"
+CONF_APPLY_LATENCY = "apply_latency"
+CONF_OFFSETS_ID = "offsets_id"
+CONF_HEALTH = "health"
+CONF_MAX_FAILURES = "max_failures"
+CONF_MAX_LATENCY = "max_latency"
+CONF_VNR = "vnr"
+CONF_VOICE_ACTIVITY = "voice_activity"
+CONF_ON_THRESHOLD = "on_threshold"
+CONF_OFF_THRESHOLD = "off_threshold"
+CONF_ATTACK = "attack"
+CONF_RELEASE = "release"
+CONF_LED_ANIMATIONS = "led_animations"
+CONF_ANIMATIONS = "animations"
+CONF_ANIMATION = "animation"
+CONF_KEYFRAMES = "keyframes"
+CONF_EASING = "easing"
+CONF_LOOP = "loop"
+CONF_FRAME_INTERVAL = "frame_interval"
+CONF_TELEMETRY = "telemetry"
+CONF_MAX_RETRIES = "max_retries"
+CONF_BEAM_ENERGY = "beam_energy"
+CONF_CAPTURE = "capture"
+CONF_SCHEDULE = "schedule"
+CONF_QUIET_WINDOW = "quiet_window"
+CONF_QUIET_VNR = "quiet_vnr"
+CONF_START = "start"
+CONF_END = "end"
+CONF_VOICE_ASSISTANT_ID = "voice_assistant_id"
+CONF_MAX_DEFER = "max_defer"
+CONF_UPDATE_PENDING = "update_pending"
+CONF_ESTIMATED_DURATION = "estimated_duration"
+CONF_FORCE = "force"
+CONF_DSP_DIAGNOSTICS = "dsp_diagnostics"
+CONF_MIN_CHANGE = "min_change"
+CONF_PARAMETER = "parameter"
+CONF_EXCLUSION_ZONES = "exclusion_zones"
+CONF_ZONES = "zones"
+CONF_FROM = "from"
+CONF_TO = "to"
+CONF_WINDOW = "window"
+CONF_LEARNING = "learning"
+CONF_HALF_LIFE = "half_life"
+CONF_BEAM_1 = "beam_1"
+CONF_BEAM_2 = "beam_2"
+CONF_FREE_RUNNING = "free_running"
+CONF_AUTO_SELECT = "auto_select"
+CONF_MIN_LEVEL = "min_level"
+CONF_MAX_LEVEL = "max_level"
+CONF_EFFECT = "effect"
+CONF_COLOR = "color"
+
+
+# Audio manager output channel presets as (category, source) pairs. Processed-data
+# sources follow the azimuth slot order of AEC_AZIMUTH_VALUES: fixed beam 1, fixed
+# beam 2, free-running beam, auto-select (ASR) beam.
+OUTPUT_CHANNEL_PRESETS = {
+    "silence": (0, 0),
+    "fixed_beam_1": (6, 0),
+    "fixed_beam_2": (6, 1),
+    "free_running_beam": (6, 2),
+    "asr_beam": (6, 3),
+    "comms": (9, 0),
+    "reference": (4, 0),
+}
 
 DOMAIN = "respeaker_xvf3800"
 
@@ -35,10 +151,76 @@ DOMAIN = "respeaker_xvf3800"
 respeaker_xvf3800_ns = cg.esphome_ns.namespace('respeaker_xvf3800')
 RespeakerXVF3800 = respeaker_xvf3800_ns.class_('RespeakerXVF3800', cg.Component, i2c.I2CDevice)
 RespeakerXVF3800FlashAction = respeaker_xvf3800_ns.class_("RespeakerXVF3800FlashAction", automation.Action)
+RespeakerXVF3800ApplyProfileAction = respeaker_xvf3800_ns.class_(
+    "RespeakerXVF3800ApplyProfileAction", automation.Action
+)
+RespeakerXVF3800PlayLedAnimationAction = respeaker_xvf3800_ns.class_(
+    "RespeakerXVF3800PlayLedAnimationAction", automation.Action
+)
+RespeakerXVF3800StopLedAnimationAction = respeaker_xvf3800_ns.class_(
+    "RespeakerXVF3800StopLedAnimationAction", automation.Action
+)
+RespeakerXVF3800StartEnergyEffectAction = respeaker_xvf3800_ns.class_(
+    "RespeakerXVF3800StartEnergyEffectAction", automation.Action
+)
+RespeakerXVF3800StopEnergyEffectAction = respeaker_xvf3800_ns.class_(
+    "RespeakerXVF3800StopEnergyEffectAction", automation.Action
+)
+RespeakerXVF3800StartCaptureAction = respeaker_xvf3800_ns.class_(
+    "RespeakerXVF3800StartCaptureAction", automation.Action
+)
+RespeakerXVF3800StopCaptureAction = respeaker_xvf3800_ns.class_(
+    "RespeakerXVF3800StopCaptureAction", automation.Action
+)
+RespeakerXVF3800ExportCaptureAction = respeaker_xvf3800_ns.class_(
+    "RespeakerXVF3800ExportCaptureAction", automation.Action
+)
+RespeakerXVF3800ReportFalseWakeAction = respeaker_xvf3800_ns.class_(
+    "RespeakerXVF3800ReportFalseWakeAction", automation.Action
+)
+RespeakerXVF3800ClearLearnedExclusionsAction = respeaker_xvf3800_ns.class_(
+    "RespeakerXVF3800ClearLearnedExclusionsAction", automation.Action
+)
+RespeakerXVF3800WakeExcludedCondition = respeaker_xvf3800_ns.class_(
+    "RespeakerXVF3800WakeExcludedCondition", automation.Condition
+)
+RespeakerXVF3800DumpTraceAction = respeaker_xvf3800_ns.class_(
+    "RespeakerXVF3800DumpTraceAction", automation.Action
+)
+RespeakerXVF3800CalibrateAecDelayAction = respeaker_xvf3800_ns.class_(
+    "RespeakerXVF3800CalibrateAecDelayAction", automation.Action
+)
+
+# Child entities are polled by the hub, not by components of their own
+MuteSwitch = respeaker_xvf3800_ns.class_('MuteSwitch', switch.Switch)
+DFUVersionTextSensor = respeaker_xvf3800_ns.class_('DFUVersionTextSensor', text_sensor.TextSensor)
+LEDBeamSensor = respeaker_xvf3800_ns.class_('LEDBeamSensor', sensor.Sensor)
 
-MuteSwitch = respeaker_xvf3800_ns.class_('MuteSwitch', switch.Switch, cg.PollingComponent)
-DFUVersionTextSensor = respeaker_xvf3800_ns.class_('DFUVersionTextSensor', text_sensor.TextSensor, cg.PollingComponent)
-LEDBeamSensor = respeaker_xvf3800_ns.class_('LEDBeamSensor', sensor.Sensor, cg.PollingComponent)
+# Must match BusClass in bus_scheduler.h
+BusClass = respeaker_xvf3800_ns.enum("BusClass")
+BUS_CLASSES = {
+    "control": BusClass.BUS_CLASS_CONTROL,
+    "audio": BusClass.BUS_CLASS_AUDIO,
+    "led": BusClass.BUS_CLASS_LED,
+    "telemetry": BusClass.BUS_CLASS_TELEMETRY,
+    "dfu": BusClass.BUS_CLASS_DFU,
+}
+
+# Must match OutputWordFormat in respeaker_xvf3800.h
+OutputWordFormat = respeaker_xvf3800_ns.enum("OutputWordFormat")
+OUTPUT_WORD_FORMATS = {
+    "int32": OutputWordFormat.OUTPUT_WORD_INT32,
+    "packed": OutputWordFormat.OUTPUT_WORD_PACKED,
+}
+
+# Must match DspValueType in respeaker_xvf3800.h
+DspValueType = respeaker_xvf3800_ns.enum("DspValueType")
+DSP_VALUE_TYPES = {
+    "uint8": DspValueType.DSP_VALUE_UINT8,
+    "int32": DspValueType.DSP_VALUE_INT32,
+    "uint32": DspValueType.DSP_VALUE_UINT32,
+    "float": DspValueType.DSP_VALUE_FLOAT,
+}
 
 DFUEndTrigger = respeaker_xvf3800_ns.class_("DFUEndTrigger", automation.Trigger.template())
 DFUErrorTrigger = respeaker_xvf3800_ns.class_("DFUErrorTrigger", automation.Trigger.template())
@@ -73,29 +255,553 @@ def download_firmware(config):
 
     return config
 
-# Define the configuration schema for the component
+def _minute_of_day(value):
+    value = cv.string_strict(value)
+    try:
+        hour, minute = (int(part) for part in value.split(":"))
+    except ValueError as e:
+        raise cv.Invalid(f"Expected HH:MM, got {value}") from e
+    if not (0 <= hour < 24 and 0 <= minute < 60):
+        raise cv.Invalid(f"Expected HH:MM, got {value}")
+    return hour * 60 + minute
+
+
+def _validate_quiet_window(config):
+    if config[CONF_START] == config[CONF_END]:
+        raise cv.Invalid(f"{CONF_START} and {CONF_END} must differ")
+    return config
+
+
+# Defers updates (on a version mismatch at boot or from respeaker_xvf3800.flash) until the
+# array is not needed: inside the quiet window if the update fits, or after VNR stayed low
+# for a while. Never during a voice assistant session.
+DFU_SCHEDULE_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_QUIET_WINDOW): cv.All(
+                cv.Schema(
+                    {
+                        cv.GenerateID(CONF_TIME_ID): cv.use_id(time_.RealTimeClock),
+                        # Local time, may wrap past midnight
+                        cv.Required(CONF_START): _minute_of_day,
+                        cv.Required(CONF_END): _minute_of_day,
+                    }
+                ),
+                _validate_quiet_window,
+            ),
+            cv.Optional(CONF_QUIET_VNR): cv.Schema(
+                {
+                    cv.Optional(CONF_THRESHOLD, default=10): cv.int_range(min=0, max=100),
+                    cv.Optional(CONF_DURATION, default="10min"): cv.positive_time_period_milliseconds,
+                }
+            ),
+            cv.Optional(CONF_VOICE_ASSISTANT_ID): cv.use_id(voice_assistant.VoiceAssistant),
+            # Starts the update anyway once it was deferred this long
+            cv.Optional(CONF_MAX_DEFER): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_UPDATE_PENDING): binary_sensor.binary_sensor_schema(
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                icon="mdi:update",
+            ),
+            cv.Optional(CONF_ESTIMATED_DURATION): sensor.sensor_schema(
+                unit_of_measurement=UNIT_SECOND,
+                accuracy_decimals=0,
+                device_class=DEVICE_CLASS_DURATION,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                icon="mdi:timer-sand",
+            ),
+        }
+    ),
+    cv.has_at_least_one_key(CONF_QUIET_WINDOW, CONF_QUIET_VNR),
+)
+
+OUTPUT_CHANNEL_SCHEMA = cv.Any(
+    cv.one_of(*OUTPUT_CHANNEL_PRESETS, lower=True),
+    cv.Schema(
+        {
+            cv.Required(CONF_CATEGORY): cv.int_range(min=0, max=12),
+            cv.Required(CONF_SOURCE): cv.uint8_t,
+        }
+    ),
+)
+
+
+def _output_channel(value):
+    if isinstance(value, str):
+        return OUTPUT_CHANNEL_PRESETS[value]
+    return value[CONF_CATEGORY], value[CONF_SOURCE]
+
+
+def _validate_output(config):
+    if config[CONF_WORD_FORMAT] == "packed" and config[CONF_SAMPLE_RATE] != 16000:
+        raise cv.Invalid(f"Packed output carries 16 kHz samples; set {CONF_SAMPLE_RATE} to 16000")
+    return config
+
+
+OUTPUT_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_SAMPLE_RATE, default=48000): cv.one_of(16000, 48000, int=True),
+            cv.Optional(CONF_LEFT, default="asr_beam"): OUTPUT_CHANNEL_SCHEMA,
+            cv.Optional(CONF_RIGHT, default="comms"): OUTPUT_CHANNEL_SCHEMA,
+            # The I2S words stay 32 bits wide (fixed by the firmware build), so the microphone
+            # keeps bits_per_sample: 32 in either format
+            cv.Optional(CONF_WORD_FORMAT, default="int32"): cv.enum(OUTPUT_WORD_FORMATS, lower=True),
+        }
+    ),
+    _validate_output,
+)
+
+def _validate_aec_calibration(config):
+    if config[CONF_MIN_VALUE] > config[CONF_MAX_VALUE]:
+        raise cv.Invalid(f"{CONF_MIN_VALUE} must not be greater than {CONF_MAX_VALUE}")
+    return config
+
+
+# Delays are in 16 kHz samples (AUDIO_MGR_SYS_DELAY)
+AEC_CALIBRATION_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Required(CONF_SPEAKER): cv.use_id(speaker.Speaker),
+            cv.Optional(CONF_MIN_VALUE, default=0): cv.int_range(min=-64, max=256),
+            cv.Optional(CONF_MAX_VALUE, default=64): cv.int_range(min=-64, max=256),
+            cv.Optional(CONF_STEP, default=4): cv.int_range(min=1, max=64),
+            cv.Optional(CONF_DWELL_TIME, default="1500ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(min=cv.TimePeriod(milliseconds=400)),
+            ),
+        }
+    ),
+    _validate_aec_calibration,
+)
+
+# XMOS parameter value types as struct format characters (XS3 is little-endian)
+PARAMETER_TYPES = {
+    "uint8": "B",
+    "int32": "i",
+    "uint32": "I",
+    "float": "f",
+}
+XMOS_MAX_WRITE_BYTES = 64  # must match respeaker_xvf3800.h
+XMOS_MAX_READ_BYTES = 64  # must match respeaker_xvf3800.h
+
+
+def _pack_parameter(config):
+    fmt = PARAMETER_TYPES[config[CONF_TYPE]]
+    values = config[CONF_VALUE]
+    if fmt != "f":
+        if any(value != int(value) for value in values):
+            raise cv.Invalid(f"Values of type {config[CONF_TYPE]} must be integers")
+        values = [int(value) for value in values]
+    try:
+        return struct.pack(f"<{len(values)}{fmt}", *values)
+    except struct.error as e:
+        raise cv.Invalid(f"Value does not fit type {config[CONF_TYPE]}: {e}") from e
+
+
+def _validate_parameter(config):
+    if len(_pack_parameter(config)) > XMOS_MAX_WRITE_BYTES:
+        raise cv.Invalid(f"Parameter payload is limited to {XMOS_MAX_WRITE_BYTES} bytes")
+    return config
+
+
+def _validate_acoustic_profiles(config):
+    names = [profile[CONF_NAME] for profile in config[CONF_PROFILES]]
+    if len(names) != len(set(names)):
+        raise cv.Invalid("Acoustic profile names must be unique")
+    # The same parameter must have the same size everywhere, it shares one shadow slot
+    sizes = {}
+    for profile in config[CONF_PROFILES]:
+        for param in profile[CONF_PARAMETERS]:
+            key = (param[CONF_RESID], param[CONF_CMD])
+            size = len(_pack_parameter(param))
+            if sizes.setdefault(key, size) != size:
+                raise cv.Invalid(
+                    f"Parameter {key[0]}/{key[1]} is written with different sizes in different profiles"
+                )
+    return config
+
+
+PARAMETER_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Required(CONF_RESID): cv.uint8_t,
+            cv.Required(CONF_CMD): cv.int_range(min=0, max=127),
+            cv.Required(CONF_TYPE): cv.one_of(*PARAMETER_TYPES, lower=True),
+            cv.Required(CONF_VALUE): cv.All(cv.ensure_list(cv.float_), cv.Length(min=1)),
+        }
+    ),
+    _validate_parameter,
+)
+
+ACOUSTIC_PROFILES_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Required(CONF_PROFILES): cv.ensure_list(
+                cv.Schema(
+                    {
+                        cv.Required(CONF_NAME): cv.string_strict,
+                        cv.Required(CONF_PARAMETERS): cv.All(
+                            cv.ensure_list(PARAMETER_SCHEMA), cv.Length(min=1)
+                        ),
+                        cv.GenerateID(CONF_RAW_DATA_ID): cv.declare_id(cg.uint8),
+                        cv.GenerateID(CONF_OFFSETS_ID): cv.declare_id(cg.uint16),
+                    }
+                )
+            ),
+            cv.Optional(CONF_APPLY_LATENCY): sensor.sensor_schema(
+                unit_of_measurement=UNIT_MICROSECOND,
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_MEASUREMENT,
+                entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                icon="mdi:timer-outline",
+            ),
+        }
+    ),
+    _validate_acoustic_profiles,
+)
+
+# Status parameters from the firmware's parameter list (resid, cmd, type); other read-only
+# parameters can be given by resid/cmd/type directly
+DSP_PARAMETERS = {
+    "aec_path_change": (33, 0, "int32"),  # AEC_AECPATHCHANGE: echo path change detected
+    "aec_converged": (33, 3, "int32"),  # AEC_AECCONVERGED
+    "aec_rt60": (33, 9, "float"),  # AEC_RT60: reverberation time estimate, seconds
+    "pipeline_idle_time": (35, 2, "int32"),  # AUDIO_MGR_CURRENT_IDLE_TIME: headroom of the audio pipeline
+    "reference_delay": (35, 26, "int32"),  # AUDIO_MGR_SYS_DELAY, samples
+}
+
+
+def _validate_dsp_diagnostic(config):
+    if CONF_PARAMETER in config:
+        if any(key in config for key in (CONF_RESID, CONF_CMD, CONF_TYPE)):
+            raise cv.Invalid(f"Use either {CONF_PARAMETER} or {CONF_RESID}/{CONF_CMD}/{CONF_TYPE}")
+        config[CONF_RESID], config[CONF_CMD], config[CONF_TYPE] = DSP_PARAMETERS[config[CONF_PARAMETER]]
+    elif not all(key in config for key in (CONF_RESID, CONF_CMD, CONF_TYPE)):
+        raise cv.Invalid(f"Either {CONF_PARAMETER} or {CONF_RESID}, {CONF_CMD} and {CONF_TYPE} are required")
+    size = struct.calcsize(PARAMETER_TYPES[config[CONF_TYPE]])
+    if (config[CONF_INDEX] + 1) * size > XMOS_MAX_READ_BYTES:
+        raise cv.Invalid(f"{CONF_INDEX} reads past the {XMOS_MAX_READ_BYTES} byte parameter limit")
+    return config
+
+
+def _validate_dsp_diagnostics(config):
+    types = {}
+    for entry in config[CONF_SENSORS]:
+        key = (entry[CONF_RESID], entry[CONF_CMD])
+        if types.setdefault(key, entry[CONF_TYPE]) != entry[CONF_TYPE]:
+            raise cv.Invalid(f"Parameter {key[0]}/{key[1]} is read with different types")
+    return config
+
+
+# AEC and audio manager state for diagnosing a satellite that stopped hearing; all parameters
+# are read back to back once per interval and each command only once
+DSP_DIAGNOSTICS_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_UPDATE_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+            cv.Required(CONF_SENSORS): cv.All(
+                cv.ensure_list(
+                    cv.All(
+                        sensor.sensor_schema(
+                            state_class=STATE_CLASS_MEASUREMENT,
+                            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+                            icon="mdi:chip",
+                        ).extend(
+                            {
+                                cv.Optional(CONF_PARAMETER): cv.one_of(*DSP_PARAMETERS, lower=True),
+                                cv.Optional(CONF_RESID): cv.uint8_t,
+                                cv.Optional(CONF_CMD): cv.int_range(min=0, max=127),
+                                cv.Optional(CONF_TYPE): cv.one_of(*PARAMETER_TYPES, lower=True),
+                                # Value of a multi-value parameter
+                                cv.Optional(CONF_INDEX, default=0): cv.int_range(min=0, max=63),
+                                cv.Optional(CONF_MIN_CHANGE, default=0.0): cv.positive_float,
+                            }
+                        ),
+                        _validate_dsp_diagnostic,
+                    )
+                ),
+                cv.Length(min=1),
+            ),
+        }
+    ),
+    _validate_dsp_diagnostics,
+)
+
+# Directions (degrees in the array frame, as the LED beam sensor's azimuth) from which wake
+# words are ignored. Learned zones come from wakes reported false with report_false_wake.
+EXCLUSION_ZONES_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_ZONES, default=[]): cv.ensure_list(
+            cv.Schema(
+                {
+                    # Inclusive; wraps past 0 when from > to
+                    cv.Required(CONF_FROM): cv.int_range(min=0, max=359),
+                    cv.Required(CONF_TO): cv.int_range(min=0, max=359),
+                }
+            )
+        ),
+        # Directions heard this long before the wake word detection make up its direction
+        cv.Optional(CONF_WINDOW, default="1500ms"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_UPDATE_INTERVAL, default="100ms"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_LEARNING): cv.Schema(
+            {
+                # False wakes from within about 10 degrees before the direction is excluded
+                cv.Optional(CONF_THRESHOLD, default=3): cv.float_range(min=1.0),
+                cv.Optional(CONF_HALF_LIFE, default="7d"): cv.positive_time_period_milliseconds,
+            }
+        ),
+    }
+)
+
+# Must match LedEasing in led_animation.h
+LED_EASINGS = {
+    "linear": 0,
+    "ease_in": 1,
+    "ease_out": 2,
+    "ease_in_out": 3,
+    "step": 4,
+}
+LED_RING_LEDS = 12
+
+
+def _validate_keyframe_colors(value):
+    if len(value) not in (1, LED_RING_LEDS):
+        raise cv.Invalid(f"Give either one color for the whole ring or {LED_RING_LEDS} colors")
+    return value
+
+
+def _validate_led_animations(config):
+    names = [animation[CONF_NAME] for animation in config[CONF_ANIMATIONS]]
+    if len(names) != len(set(names)):
+        raise cv.Invalid("LED animation names must be unique")
+    return config
+
+
+# Each keyframe fades into the next over its duration with its easing; looping animations
+# fade from the last keyframe back into the first. Compiled into constant tables.
+LED_KEYFRAME_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_COLORS): cv.All(
+            cv.ensure_list(cv.hex_int_range(min=0, max=0xFFFFFF)), _validate_keyframe_colors
+        ),
+        cv.Optional(CONF_DURATION, default="500ms"): cv.All(
+            cv.positive_time_period_milliseconds,
+            cv.Range(max=cv.TimePeriod(milliseconds=65535)),
+        ),
+        cv.Optional(CONF_EASING, default="linear"): cv.one_of(*LED_EASINGS, lower=True),
+    }
+)
+
+LED_ANIMATIONS_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_FRAME_INTERVAL, default="50ms"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(min=cv.TimePeriod(milliseconds=10)),
+            ),
+            cv.Required(CONF_ANIMATIONS): cv.ensure_list(
+                cv.Schema(
+                    {
+                        cv.Required(CONF_NAME): cv.string_strict,
+                        cv.Optional(CONF_LOOP, default=True): cv.boolean,
+                        cv.Required(CONF_KEYFRAMES): cv.All(
+                            cv.ensure_list(LED_KEYFRAME_SCHEMA), cv.Length(min=1, max=255)
+                        ),
+                        cv.GenerateID(CONF_RAW_DATA_ID): cv.declare_id(cg.uint8),
+                    }
+                )
+            ),
+        }
+    ),
+    _validate_led_animations,
+)
+
+# Budgets are the share of each 100ms window a traffic class may occupy; 0% = unlimited, the
+# default. Only LED frames and telemetry polls can be deferred, so only they take a budget.
+BUDGET_CLASSES = ("led", "telemetry")
+BUS_SCHEDULER_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_FREQUENCY, default="100kHz"): cv.All(
+            cv.frequency, cv.Range(min=10e3, max=1e6)
+        ),
+        cv.Optional(CONF_BUDGETS, default={}): cv.Schema(
+            {
+                cv.Optional(name, default=0): cv.percentage
+                for name in BUDGET_CLASSES
+            }
+        ),
+        cv.Optional(CONF_UPDATE_INTERVAL, default="10s"): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_UTILIZATION): sensor.sensor_schema(
+            unit_of_measurement=UNIT_PERCENT,
+            accuracy_decimals=1,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            icon="mdi:swap-horizontal",
+        ),
+    }
+)
+
+# max_failures I2C errors in a row start the recovery: retries, a bus resync, then a hard reset
+# through reset_pin. Transfers slower than max_latency are only logged, never recovered from.
+# The resync is an address-only transaction after a quiet period; it brings back a slave that
+# lost track of a transfer, but can not free one holding SDA low (SCL is owned by the I2C
+# driver and is not clocked by hand), which needs reset_pin.
+HEALTH_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_MAX_FAILURES, default=3): cv.int_range(min=1, max=100),
+        cv.Optional(CONF_MAX_LATENCY, default="50ms"): cv.All(
+            cv.positive_time_period_microseconds,
+            cv.Range(min=cv.TimePeriod(milliseconds=5)),
+        ),
+    }
+)
+
+def _validate_voice_activity(config):
+    if config[CONF_OFF_THRESHOLD] > config[CONF_ON_THRESHOLD]:
+        raise cv.Invalid(f"{CONF_OFF_THRESHOLD} must not be greater than {CONF_ON_THRESHOLD}")
+    return config
+
+
+# VNR is the XMOS voice-to-noise estimate, 0-100. Voice activity (also available to lambdas as
+# is_voice_active()) uses the thresholds with attack/release hold times.
+VNR_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_UPDATE_INTERVAL, default="100ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_SENSOR): sensor.sensor_schema(
+                accuracy_decimals=0,
+                state_class=STATE_CLASS_MEASUREMENT,
+                icon="mdi:account-voice",
+            ),
+            cv.Optional(CONF_VOICE_ACTIVITY): binary_sensor.binary_sensor_schema(device_class=DEVICE_CLASS_SOUND),
+            cv.Optional(CONF_ON_THRESHOLD, default=60): cv.int_range(min=0, max=100),
+            cv.Optional(CONF_OFF_THRESHOLD, default=40): cv.int_range(min=0, max=100),
+            cv.Optional(CONF_ATTACK, default="50ms"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_RELEASE, default="500ms"): cv.positive_time_period_milliseconds,
+        }
+    ),
+    _validate_voice_activity,
+)
+
+# Slots of AEC_SPENERGY_VALUES, same order as the azimuth slots
+BEAM_ENERGY_SENSORS = [CONF_BEAM_1, CONF_BEAM_2, CONF_FREE_RUNNING, CONF_AUTO_SELECT]
+
+
+def _validate_level_range(config):
+    if config[CONF_MIN_LEVEL] >= config[CONF_MAX_LEVEL]:
+        raise cv.Invalid(f"{CONF_MIN_LEVEL} must be below {CONF_MAX_LEVEL}")
+    return config
+
+
+# Per-beam speech energy (AEC_SPENERGY_VALUES), read together with the azimuth
+BEAM_ENERGY_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_UPDATE_INTERVAL, default="100ms"): cv.positive_time_period_milliseconds,
+            **{
+                cv.Optional(key): sensor.sensor_schema(
+                    unit_of_measurement=UNIT_DECIBEL,
+                    accuracy_decimals=0,
+                    state_class=STATE_CLASS_MEASUREMENT,
+                    icon="mdi:waveform",
+                )
+                for key in BEAM_ENERGY_SENSORS
+            },
+            # Level range the energy LED effect spans, from dark to the full ring
+            cv.Optional(CONF_MIN_LEVEL, default=-60.0): cv.float_,
+            cv.Optional(CONF_MAX_LEVEL, default=0.0): cv.float_,
+            cv.Optional(CONF_EFFECT): cv.Schema(
+                {
+                    cv.Optional(CONF_COLOR, default=0x00A0FF): cv.hex_int_range(min=0, max=0xFFFFFF),
+                    cv.Optional(CONF_RELEASE, default="300ms"): cv.positive_time_period_milliseconds,
+                }
+            ),
+        }
+    ),
+    _validate_level_range,
+)
+
+# Ring buffer of beam-tracking inputs for misc/capture_replay.cpp; 28 bytes per record,
+# placed in PSRAM when available
+CAPTURE_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_SIZE, default=2048): cv.int_range(min=16, max=65536),
+        cv.Optional(CONF_UPDATE_INTERVAL, default="100ms"): cv.positive_time_period_milliseconds,
+    }
+)
+
+# `never` leaves the entity out of the poll table
+def _poll_interval_schema(default):
+    return cv.Schema({cv.Optional(CONF_UPDATE_INTERVAL, default=default): cv.update_interval})
+
+
+# Child entities, VNR, beam energy and exclusion zones are driven by the hub's poll table: all
+# tasks run on one tick and the reads of tasks coming due together go out as one bus sweep,
+# each read once. Intervals that are multiples of each other keep those sweeps merged.
 CONFIG_SCHEMA = cv.Schema({
     cv.GenerateID(): cv.declare_id(RespeakerXVF3800),
     cv.Optional(CONF_MUTE_SWITCH): switch.switch_schema(
         MuteSwitch,
         icon="mdi:microphone-off",
-    ).extend(cv.polling_component_schema("1s")),
+    ).extend(_poll_interval_schema("1s")),
     cv.Optional(CONF_DFU_VERSION): text_sensor.text_sensor_schema(
         DFUVersionTextSensor,
         icon="mdi:chip",
-    ).extend(cv.polling_component_schema("30s")),
+    ).extend(_poll_interval_schema("30s")),
     cv.Optional(CONF_LED_BEAM_SENSOR): sensor.sensor_schema(
         LEDBeamSensor,
         icon="mdi:led-on",
         accuracy_decimals=0,
         unit_of_measurement="",
-    ).extend(cv.polling_component_schema("100ms")),
+    ).extend(_poll_interval_schema("100ms")),
+    # set_led_ring() and lock_beam()/unlock_beam() for use from lambdas. On by default so
+    # existing lambdas keep compiling; set false to drop them from the build. led_animations
+    # implies led_ring.
+    cv.Optional(CONF_LED_RING, default=True): cv.boolean,
+    cv.Optional(CONF_BEAM_LOCK, default=True): cv.boolean,
+    cv.Optional(CONF_OUTPUT): OUTPUT_SCHEMA,
+    cv.Optional(CONF_AEC_CALIBRATION): AEC_CALIBRATION_SCHEMA,
+    cv.Optional(CONF_VNR): VNR_SCHEMA,
+    cv.Optional(CONF_BEAM_ENERGY): BEAM_ENERGY_SCHEMA,
+    cv.Optional(CONF_CAPTURE): CAPTURE_SCHEMA,
+    cv.Optional(CONF_DSP_DIAGNOSTICS): DSP_DIAGNOSTICS_SCHEMA,
+    cv.Optional(CONF_EXCLUSION_ZONES): EXCLUSION_ZONES_SCHEMA,
+    # Azimuths, VNR, mute, GPO bits, beam lock and bus statistics read in one sweep and
+    # published as a single text state when it changes (format in respeaker_xvf3800.h)
+    cv.Optional(CONF_TELEMETRY): text_sensor.text_sensor_schema(
+        entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        icon="mdi:chart-box-outline",
+    ).extend(
+        {
+            cv.Optional(CONF_UPDATE_INTERVAL, default="1s"): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(min=cv.TimePeriod(milliseconds=100)),
+            ),
+        }
+    ),
+    cv.Optional(CONF_BUS_SCHEDULER, default={}): BUS_SCHEDULER_SCHEMA,
+    cv.Optional(CONF_RESET_PIN): pins.gpio_output_pin_schema,
+    cv.Optional(CONF_HEALTH, default={}): HEALTH_SCHEMA,
+    # Moves XMOS traffic onto a dedicated task; completions run from the hub's loop()
+    cv.Optional(CONF_CONTROL_TASK, default=False): cv.boolean,
+    # Binary ring buffer of hot-path bus events, dumped with respeaker_xvf3800.dump_trace
+    cv.Optional(CONF_TRACE): cv.Schema(
+        {
+            cv.Optional(CONF_SIZE, default=256): cv.one_of(64, 128, 256, 512, 1024, int=True),
+        }
+    ),
+    cv.Optional(CONF_ACOUSTIC_PROFILES): ACOUSTIC_PROFILES_SCHEMA,
+    cv.Optional(CONF_LED_ANIMATIONS): LED_ANIMATIONS_SCHEMA,
     cv.GenerateID(CONF_RAW_DATA_ID): cv.declare_id(cg.uint8),
     cv.Optional(CONF_FIRMWARE): cv.All(
                 {
                     cv.Required(CONF_URL): cv.url,
                     cv.Required(CONF_VERSION): cv.version_number,
                     cv.Required(CONF_MD5): cv.All(cv.string, cv.Length(min=32, max=32)),
+                    # Failed updates are retried with backoff, then the factory image is booted;
+                    # that image (by md5) is then not flashed again on boot
+                    cv.Optional(CONF_MAX_RETRIES, default=3): cv.int_range(min=0, max=8),
+                    cv.Optional(CONF_SCHEDULE): DFU_SCHEDULE_SCHEMA,
                     cv.Optional(CONF_ON_BEGIN): automation.validate_automation(
                         {
                             cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(
@@ -136,16 +842,196 @@ OTA_RESPEAKER_XVF3800_FLASH_ACTION_SCHEMA = cv.Schema(
     }
 )
 
+# Actions that only need the hub
+RESPEAKER_XVF3800_ACTION_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(RespeakerXVF3800),
+    }
+)
+
 
 @automation.register_action(
     "respeaker_xvf3800.flash",
     RespeakerXVF3800FlashAction,
-    OTA_RESPEAKER_XVF3800_FLASH_ACTION_SCHEMA,
+    OTA_RESPEAKER_XVF3800_FLASH_ACTION_SCHEMA.extend(
+        {
+            # Flash right away instead of waiting for the firmware schedule
+            cv.Optional(CONF_FORCE, default=False): cv.boolean,
+        }
+    ),
     synchronous=False,
 )
 async def respeaker_xxvf3800_flash_action_to_code(config, action_id, template_arg, args):
     paren = await cg.get_variable(config[CONF_ID])
     var = cg.new_Pvariable(action_id, template_arg, paren)
+    if config[CONF_FORCE]:
+        cg.add(var.set_force(True))
+
+    return var
+
+@automation.register_action(
+    "respeaker_xvf3800.calibrate_aec_delay",
+    RespeakerXVF3800CalibrateAecDelayAction,
+    RESPEAKER_XVF3800_ACTION_SCHEMA,
+)
+async def respeaker_xvf3800_calibrate_aec_delay_action_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+
+    return var
+
+@automation.register_action(
+    "respeaker_xvf3800.dump_trace",
+    RespeakerXVF3800DumpTraceAction,
+    RESPEAKER_XVF3800_ACTION_SCHEMA,
+)
+async def respeaker_xvf3800_dump_trace_action_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+
+    return var
+
+@automation.register_action(
+    "respeaker_xvf3800.play_led_animation",
+    RespeakerXVF3800PlayLedAnimationAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(RespeakerXVF3800),
+            cv.Required(CONF_ANIMATION): cv.templatable(cv.string_strict),
+            cv.Optional(CONF_BRIGHTNESS, default=1.0): cv.templatable(cv.percentage),
+        }
+    ),
+)
+async def respeaker_xvf3800_play_led_animation_action_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+    template_ = await cg.templatable(config[CONF_ANIMATION], args, cg.std_string)
+    cg.add(var.set_animation(template_))
+    template_ = await cg.templatable(config[CONF_BRIGHTNESS], args, cg.float_)
+    cg.add(var.set_brightness(template_))
+
+    return var
+
+@automation.register_action(
+    "respeaker_xvf3800.stop_led_animation",
+    RespeakerXVF3800StopLedAnimationAction,
+    RESPEAKER_XVF3800_ACTION_SCHEMA,
+)
+async def respeaker_xvf3800_stop_led_animation_action_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+
+    return var
+
+@automation.register_action(
+    "respeaker_xvf3800.start_energy_effect",
+    RespeakerXVF3800StartEnergyEffectAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(RespeakerXVF3800),
+            cv.Optional(CONF_BRIGHTNESS, default=1.0): cv.templatable(cv.percentage),
+        }
+    ),
+)
+async def respeaker_xvf3800_start_energy_effect_action_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+    template_ = await cg.templatable(config[CONF_BRIGHTNESS], args, cg.float_)
+    cg.add(var.set_brightness(template_))
+
+    return var
+
+@automation.register_action(
+    "respeaker_xvf3800.stop_energy_effect",
+    RespeakerXVF3800StopEnergyEffectAction,
+    RESPEAKER_XVF3800_ACTION_SCHEMA,
+)
+async def respeaker_xvf3800_stop_energy_effect_action_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+
+    return var
+
+@automation.register_action(
+    "respeaker_xvf3800.start_capture",
+    RespeakerXVF3800StartCaptureAction,
+    RESPEAKER_XVF3800_ACTION_SCHEMA,
+)
+async def respeaker_xvf3800_start_capture_action_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+
+    return var
+
+@automation.register_action(
+    "respeaker_xvf3800.stop_capture",
+    RespeakerXVF3800StopCaptureAction,
+    RESPEAKER_XVF3800_ACTION_SCHEMA,
+)
+async def respeaker_xvf3800_stop_capture_action_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+
+    return var
+
+@automation.register_action(
+    "respeaker_xvf3800.export_capture",
+    RespeakerXVF3800ExportCaptureAction,
+    RESPEAKER_XVF3800_ACTION_SCHEMA,
+)
+async def respeaker_xvf3800_export_capture_action_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+
+    return var
+
+@automation.register_action(
+    "respeaker_xvf3800.report_false_wake",
+    RespeakerXVF3800ReportFalseWakeAction,
+    RESPEAKER_XVF3800_ACTION_SCHEMA,
+)
+async def respeaker_xvf3800_report_false_wake_action_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+
+    return var
+
+@automation.register_action(
+    "respeaker_xvf3800.clear_learned_exclusions",
+    RespeakerXVF3800ClearLearnedExclusionsAction,
+    RESPEAKER_XVF3800_ACTION_SCHEMA,
+)
+async def respeaker_xvf3800_clear_learned_exclusions_action_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+
+    return var
+
+# True if the wake word just detected came from an excluded direction
+@automation.register_condition(
+    "respeaker_xvf3800.wake_excluded",
+    RespeakerXVF3800WakeExcludedCondition,
+    RESPEAKER_XVF3800_ACTION_SCHEMA,
+)
+async def respeaker_xvf3800_wake_excluded_to_code(config, condition_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    return cg.new_Pvariable(condition_id, template_arg, paren)
+
+@automation.register_action(
+    "respeaker_xvf3800.apply_profile",
+    RespeakerXVF3800ApplyProfileAction,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.use_id(RespeakerXVF3800),
+            cv.Required(CONF_PROFILE): cv.templatable(cv.string_strict),
+        }
+    ),
+)
+async def respeaker_xvf3800_apply_profile_action_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+    template_ = await cg.templatable(config[CONF_PROFILE], args, cg.std_string)
+    cg.add(var.set_profile(template_))
 
     return var
 
@@ -155,30 +1041,214 @@ async def to_code(config):
     var = cg.new_Pvariable(config[CONF_ID])
     await cg.register_component(var, config)
     await i2c.register_i2c_device(var, config)
+
+    # Distinguishes the preferences of hubs sharing an I2C address on separate buses
+    data = CORE.data.setdefault(DOMAIN, {"instances": 0, "firmware": {}})
+    cg.add(var.set_instance_index(data["instances"]))
+    data["instances"] += 1
+
+    if CONF_RESET_PIN in config:
+        reset_pin = await cg.gpio_pin_expression(config[CONF_RESET_PIN])
+        cg.add(var.set_reset_pin(reset_pin))
+    health_config = config[CONF_HEALTH]
+    cg.add(var.set_health_thresholds(health_config[CONF_MAX_FAILURES], health_config[CONF_MAX_LATENCY]))
         
     # Set up mute switch if configured
     if CONF_MUTE_SWITCH in config:
         mute_switch = cg.new_Pvariable(config[CONF_MUTE_SWITCH][CONF_ID])
-        await cg.register_component(mute_switch, config[CONF_MUTE_SWITCH])
         await switch.register_switch(mute_switch, config[CONF_MUTE_SWITCH])
-        cg.add(var.set_mute_switch(mute_switch))
+        cg.add(var.set_mute_switch(mute_switch, config[CONF_MUTE_SWITCH][CONF_UPDATE_INTERVAL]))
         cg.add(mute_switch.set_parent(var))
+        cg.add_define("USE_RESPEAKER_XVF3800_MUTE_SWITCH")
         
     # Set up DFU version sensor if configured
     if CONF_DFU_VERSION in config:
         dfu_sensor = cg.new_Pvariable(config[CONF_DFU_VERSION][CONF_ID])
-        await cg.register_component(dfu_sensor, config[CONF_DFU_VERSION])
         await text_sensor.register_text_sensor(dfu_sensor, config[CONF_DFU_VERSION])
-        cg.add(var.set_dfu_version_sensor(dfu_sensor))
-        cg.add(dfu_sensor.set_parent(var))
+        cg.add(var.set_dfu_version_sensor(dfu_sensor, config[CONF_DFU_VERSION][CONF_UPDATE_INTERVAL]))
+        cg.add_define("USE_RESPEAKER_XVF3800_DFU_VERSION")
 
     # Set up LED beam sensor if configured
     if CONF_LED_BEAM_SENSOR in config:
         led_beam_sensor = cg.new_Pvariable(config[CONF_LED_BEAM_SENSOR][CONF_ID])
-        await cg.register_component(led_beam_sensor, config[CONF_LED_BEAM_SENSOR])
         await sensor.register_sensor(led_beam_sensor, config[CONF_LED_BEAM_SENSOR])
-        cg.add(var.set_led_beam_sensor(led_beam_sensor))
-        cg.add(led_beam_sensor.set_parent(var))
+        cg.add(
+            var.set_led_beam_sensor(
+                led_beam_sensor, config[CONF_LED_BEAM_SENSOR][CONF_UPDATE_INTERVAL]
+            )
+        )
+        cg.add_define("USE_RESPEAKER_XVF3800_LED_BEAM_SENSOR")
+
+    if (
+        config[CONF_LED_RING]
+        or CONF_LED_ANIMATIONS in config
+        or CONF_EFFECT in config.get(CONF_BEAM_ENERGY, {})
+    ):
+        cg.add_define("USE_RESPEAKER_XVF3800_LED_RING")
+    if config[CONF_BEAM_LOCK]:
+        cg.add_define("USE_RESPEAKER_XVF3800_BEAM_LOCK")
+
+    if output_config := config.get(CONF_OUTPUT):
+        left_category, left_source = _output_channel(output_config[CONF_LEFT])
+        right_category, right_source = _output_channel(output_config[CONF_RIGHT])
+        cg.add(
+            var.set_output_config(
+                left_category,
+                left_source,
+                right_category,
+                right_source,
+                output_config[CONF_SAMPLE_RATE],
+                output_config[CONF_WORD_FORMAT],
+            )
+        )
+
+    bus_config = config[CONF_BUS_SCHEDULER]
+    cg.add(var.set_bus_frequency(int(bus_config[CONF_FREQUENCY])))
+    for name, budget in bus_config[CONF_BUDGETS].items():
+        cg.add(var.set_bus_budget(BUS_CLASSES[name], int(round(budget * 100))))
+    if CONF_UTILIZATION in bus_config:
+        sens = await sensor.new_sensor(bus_config[CONF_UTILIZATION])
+        cg.add(var.set_bus_utilization_sensor(sens))
+        cg.add(var.set_bus_report_interval(bus_config[CONF_UPDATE_INTERVAL]))
+
+    if vnr_config := config.get(CONF_VNR):
+        cg.add(var.set_vnr_update_interval(vnr_config[CONF_UPDATE_INTERVAL]))
+        if CONF_SENSOR in vnr_config:
+            sens = await sensor.new_sensor(vnr_config[CONF_SENSOR])
+            cg.add(var.set_vnr_sensor(sens))
+        if CONF_VOICE_ACTIVITY in vnr_config:
+            bin_sens = await binary_sensor.new_binary_sensor(vnr_config[CONF_VOICE_ACTIVITY])
+            cg.add(var.set_voice_activity_sensor(bin_sens))
+        cg.add(
+            var.set_voice_activity_config(
+                vnr_config[CONF_ON_THRESHOLD],
+                vnr_config[CONF_OFF_THRESHOLD],
+                vnr_config[CONF_ATTACK],
+                vnr_config[CONF_RELEASE],
+            )
+        )
+        cg.add_define("USE_RESPEAKER_XVF3800_VNR")
+
+    if energy_config := config.get(CONF_BEAM_ENERGY):
+        cg.add(var.set_beam_energy_update_interval(energy_config[CONF_UPDATE_INTERVAL]))
+        for beam, key in enumerate(BEAM_ENERGY_SENSORS):
+            if key in energy_config:
+                sens = await sensor.new_sensor(energy_config[key])
+                cg.add(var.set_beam_energy_sensor(beam, sens))
+        cg.add(var.set_beam_energy_range(energy_config[CONF_MIN_LEVEL], energy_config[CONF_MAX_LEVEL]))
+        if effect_config := energy_config.get(CONF_EFFECT):
+            cg.add(var.set_energy_effect_config(effect_config[CONF_COLOR], effect_config[CONF_RELEASE]))
+        cg.add_define("USE_RESPEAKER_XVF3800_BEAM_ENERGY")
+
+    if diagnostics_config := config.get(CONF_DSP_DIAGNOSTICS):
+        cg.add(var.set_dsp_diagnostics_interval(diagnostics_config[CONF_UPDATE_INTERVAL]))
+        # One read per command, long enough for the highest value any sensor uses
+        lengths = {}
+        for entry in diagnostics_config[CONF_SENSORS]:
+            key = (entry[CONF_RESID], entry[CONF_CMD])
+            size = struct.calcsize(PARAMETER_TYPES[entry[CONF_TYPE]])
+            lengths[key] = max(lengths.get(key, 0), (entry[CONF_INDEX] + 1) * size)
+        reads = list(lengths)
+        for resid, cmd in reads:
+            cg.add(var.add_dsp_read(resid, cmd, lengths[(resid, cmd)]))
+        for entry in diagnostics_config[CONF_SENSORS]:
+            sens = await sensor.new_sensor(entry)
+            size = struct.calcsize(PARAMETER_TYPES[entry[CONF_TYPE]])
+            cg.add(
+                var.add_dsp_diagnostic(
+                    sens,
+                    reads.index((entry[CONF_RESID], entry[CONF_CMD])),
+                    DSP_VALUE_TYPES[entry[CONF_TYPE]],
+                    entry[CONF_INDEX] * size,
+                    entry[CONF_MIN_CHANGE],
+                )
+            )
+        cg.add_define("USE_RESPEAKER_XVF3800_DSP_DIAGNOSTICS")
+
+    if exclusion_config := config.get(CONF_EXCLUSION_ZONES):
+        for zone in exclusion_config[CONF_ZONES]:
+            cg.add(var.add_exclusion_zone(zone[CONF_FROM], zone[CONF_TO]))
+        cg.add(var.set_exclusion_window(exclusion_config[CONF_WINDOW]))
+        cg.add(var.set_exclusion_update_interval(exclusion_config[CONF_UPDATE_INTERVAL]))
+        if learning_config := exclusion_config.get(CONF_LEARNING):
+            cg.add(var.set_exclusion_learning(learning_config[CONF_THRESHOLD], learning_config[CONF_HALF_LIFE]))
+        cg.add_define("USE_RESPEAKER_XVF3800_EXCLUSION_ZONES")
+
+    if capture_config := config.get(CONF_CAPTURE):
+        cg.add(var.set_capture_config(capture_config[CONF_SIZE], capture_config[CONF_UPDATE_INTERVAL]))
+        cg.add_define("USE_RESPEAKER_XVF3800_CAPTURE")
+
+    if telemetry_config := config.get(CONF_TELEMETRY):
+        sens = await text_sensor.new_text_sensor(telemetry_config)
+        cg.add(var.set_telemetry_sensor(sens))
+        cg.add(var.set_telemetry_interval(telemetry_config[CONF_UPDATE_INTERVAL]))
+        cg.add_define("USE_RESPEAKER_XVF3800_TELEMETRY")
+
+    if config[CONF_CONTROL_TASK]:
+        cg.add_define("USE_RESPEAKER_XVF3800_CONTROL_TASK")
+
+    if trace_config := config.get(CONF_TRACE):
+        cg.add_define("USE_RESPEAKER_XVF3800_TRACE")
+        cg.add_define("RESPEAKER_XVF3800_TRACE_SIZE", trace_config[CONF_SIZE])
+
+    if profiles_config := config.get(CONF_ACOUSTIC_PROFILES):
+        # Every distinct parameter gets a shadow slot: a "known" byte followed by the value
+        shadow_offsets = {}
+        shadow_size = 0
+        for profile in profiles_config[CONF_PROFILES]:
+            frames = []
+            offsets = []
+            for param in profile[CONF_PARAMETERS]:
+                payload = _pack_parameter(param)
+                key = (param[CONF_RESID], param[CONF_CMD])
+                if key not in shadow_offsets:
+                    shadow_offsets[key] = shadow_size
+                    shadow_size += 1 + len(payload)
+                offsets.append(shadow_offsets[key])
+                # Stored as the wire frame: resid, cmd, length, payload
+                frames.extend([param[CONF_RESID], param[CONF_CMD], len(payload), *payload])
+            frames_arr = cg.static_const_array(profile[CONF_RAW_DATA_ID], [HexInt(x) for x in frames])
+            offsets_arr = cg.static_const_array(profile[CONF_OFFSETS_ID], offsets)
+            cg.add(var.add_acoustic_profile(profile[CONF_NAME], frames_arr, len(frames), offsets_arr))
+        cg.add(var.set_acoustic_shadow_size(shadow_size))
+        if CONF_APPLY_LATENCY in profiles_config:
+            sens = await sensor.new_sensor(profiles_config[CONF_APPLY_LATENCY])
+            cg.add(var.set_profile_latency_sensor(sens))
+        cg.add_define("USE_RESPEAKER_XVF3800_ACOUSTIC_PROFILES")
+
+    if animations_config := config.get(CONF_LED_ANIMATIONS):
+        for animation in animations_config[CONF_ANIMATIONS]:
+            # Per keyframe: easing, duration (ms, little-endian), then RGB for each LED
+            data = []
+            for keyframe in animation[CONF_KEYFRAMES]:
+                colors = keyframe[CONF_COLORS]
+                if len(colors) == 1:
+                    colors = colors * LED_RING_LEDS
+                duration = keyframe[CONF_DURATION].total_milliseconds
+                data.extend([LED_EASINGS[keyframe[CONF_EASING]], duration & 0xFF, duration >> 8])
+                for color in colors:
+                    data.extend([(color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF])
+            data_arr = cg.static_const_array(animation[CONF_RAW_DATA_ID], [HexInt(x) for x in data])
+            cg.add(
+                var.add_led_animation(
+                    animation[CONF_NAME], data_arr, len(animation[CONF_KEYFRAMES]), animation[CONF_LOOP]
+                )
+            )
+        cg.add(var.set_led_animation_interval(animations_config[CONF_FRAME_INTERVAL]))
+        cg.add_define("USE_RESPEAKER_XVF3800_LED_ANIMATIONS")
+
+    if calibration_config := config.get(CONF_AEC_CALIBRATION):
+        spkr = await cg.get_variable(calibration_config[CONF_SPEAKER])
+        cg.add(var.set_calibration_speaker(spkr))
+        cg.add(
+            var.set_calibration_range(
+                calibration_config[CONF_MIN_VALUE],
+                calibration_config[CONF_MAX_VALUE],
+                calibration_config[CONF_STEP],
+            )
+        )
+        cg.add(var.set_calibration_dwell(calibration_config[CONF_DWELL_TIME]))
+        cg.add_define("USE_RESPEAKER_XVF3800_AEC_CALIBRATION")
 
     if config_fw := config.get(CONF_FIRMWARE):
         firmware_version = config_fw[CONF_VERSION].split(".")
@@ -190,11 +1260,37 @@ async def to_code(config):
         except FileNotFoundError as e:
             raise core.EsphomeError(f"Could not open firmware file {path}: {e}")
 
-        # Convert retrieved binary file to an array of ints
-        rhs = [HexInt(x) for x in firmware_bin]
-        # Create an array which will reside in program memory and set the pointer to it
-        firmware_bin_arr = cg.progmem_array(config[CONF_RAW_DATA_ID], rhs)
-        cg.add(var.set_firmware_bin(firmware_bin_arr, len(rhs)))
+        # Hubs flashing the same image share one array, so flash use does not grow per array
+        shared = data["firmware"].get(config_fw[CONF_MD5].lower())
+        if shared is None:
+            # Convert retrieved binary file to an array of ints
+            rhs = [HexInt(x) for x in firmware_bin]
+            # Create an array which will reside in program memory and set the pointer to it
+            shared = (cg.progmem_array(config[CONF_RAW_DATA_ID], rhs), len(rhs))
+            data["firmware"][config_fw[CONF_MD5].lower()] = shared
+        cg.add(var.set_firmware_bin(*shared))
+        cg.add(var.set_firmware_md5(config_fw[CONF_MD5].lower()))
+        cg.add(var.set_dfu_max_retries(config_fw[CONF_MAX_RETRIES]))
+        if schedule_config := config_fw.get(CONF_SCHEDULE):
+            if window_config := schedule_config.get(CONF_QUIET_WINDOW):
+                clock = await cg.get_variable(window_config[CONF_TIME_ID])
+                cg.add(var.set_dfu_time(clock))
+                cg.add(var.set_dfu_window(window_config[CONF_START], window_config[CONF_END]))
+            if vnr_config := schedule_config.get(CONF_QUIET_VNR):
+                cg.add(var.set_dfu_quiet_vnr(vnr_config[CONF_THRESHOLD], vnr_config[CONF_DURATION]))
+            if CONF_VOICE_ASSISTANT_ID in schedule_config:
+                va = await cg.get_variable(schedule_config[CONF_VOICE_ASSISTANT_ID])
+                cg.add(var.set_dfu_voice_assistant(va))
+            if CONF_MAX_DEFER in schedule_config:
+                cg.add(var.set_dfu_max_defer(schedule_config[CONF_MAX_DEFER]))
+            if pending_config := schedule_config.get(CONF_UPDATE_PENDING):
+                sens = await binary_sensor.new_binary_sensor(pending_config)
+                cg.add(var.set_update_pending_sensor(sens))
+            if duration_config := schedule_config.get(CONF_ESTIMATED_DURATION):
+                sens = await sensor.new_sensor(duration_config)
+                cg.add(var.set_update_duration_sensor(sens))
+            cg.add_define("USE_RESPEAKER_XVF3800_DFU_SCHEDULE")
+        cg.add_define("USE_RESPEAKER_XVF3800_DFU")
         cg.add(
             var.set_firmware_version(
                 int(firmware_version[0]),
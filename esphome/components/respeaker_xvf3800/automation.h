@@ -9,7 +9,142 @@ namespace respeaker_xvf3800 {
 template<typename... Ts> class RespeakerXVF3800FlashAction : public Action<Ts...> {
  public:
   RespeakerXVF3800FlashAction(RespeakerXVF3800 *parent) : parent_(parent) {}
-  void play(Ts... x) override { this->parent_->start_dfu_update(); }
+  // Skips the update schedule
+  void set_force(bool force) { this->force_ = force; }
+  void play(Ts... x) override {
+    if (this->force_) {
+      this->parent_->start_dfu_update();
+    } else {
+      this->parent_->request_dfu_update();
+    }
+  }
+
+ protected:
+  RespeakerXVF3800 *parent_;
+  bool force_{false};
+};
+
+template<typename... Ts> class RespeakerXVF3800CalibrateAecDelayAction : public Action<Ts...> {
+ public:
+  RespeakerXVF3800CalibrateAecDelayAction(RespeakerXVF3800 *parent) : parent_(parent) {}
+  void play(Ts... x) override { this->parent_->start_aec_calibration(); }
+
+ protected:
+  RespeakerXVF3800 *parent_;
+};
+template<typename... Ts> class RespeakerXVF3800ApplyProfileAction : public Action<Ts...> {
+ public:
+  RespeakerXVF3800ApplyProfileAction(RespeakerXVF3800 *parent) : parent_(parent) {}
+  TEMPLATABLE_VALUE(std::string, profile)
+
+  void play(Ts... x) override { this->parent_->apply_acoustic_profile(this->profile_.value(x...)); }
+
+ protected:
+  RespeakerXVF3800 *parent_;
+};
+
+template<typename... Ts> class RespeakerXVF3800PlayLedAnimationAction : public Action<Ts...> {
+ public:
+  RespeakerXVF3800PlayLedAnimationAction(RespeakerXVF3800 *parent) : parent_(parent) {}
+  TEMPLATABLE_VALUE(std::string, animation)
+  TEMPLATABLE_VALUE(float, brightness)
+
+  void play(Ts... x) override {
+    this->parent_->play_led_animation(this->animation_.value(x...), this->brightness_.value(x...));
+  }
+
+ protected:
+  RespeakerXVF3800 *parent_;
+};
+
+template<typename... Ts> class RespeakerXVF3800StopLedAnimationAction : public Action<Ts...> {
+ public:
+  RespeakerXVF3800StopLedAnimationAction(RespeakerXVF3800 *parent) : parent_(parent) {}
+  void play(Ts... x) override { this->parent_->stop_led_animation(); }
+
+ protected:
+  RespeakerXVF3800 *parent_;
+};
+
+template<typename... Ts> class RespeakerXVF3800StartEnergyEffectAction : public Action<Ts...> {
+ public:
+  RespeakerXVF3800StartEnergyEffectAction(RespeakerXVF3800 *parent) : parent_(parent) {}
+  TEMPLATABLE_VALUE(float, brightness)
+
+  void play(Ts... x) override { this->parent_->start_energy_effect(this->brightness_.value(x...)); }
+
+ protected:
+  RespeakerXVF3800 *parent_;
+};
+
+template<typename... Ts> class RespeakerXVF3800StopEnergyEffectAction : public Action<Ts...> {
+ public:
+  RespeakerXVF3800StopEnergyEffectAction(RespeakerXVF3800 *parent) : parent_(parent) {}
+  void play(Ts... x) override { this->parent_->stop_energy_effect(); }
+
+ protected:
+  RespeakerXVF3800 *parent_;
+};
+
+template<typename... Ts> class RespeakerXVF3800StartCaptureAction : public Action<Ts...> {
+ public:
+  RespeakerXVF3800StartCaptureAction(RespeakerXVF3800 *parent) : parent_(parent) {}
+  void play(Ts... x) override { this->parent_->start_capture(); }
+
+ protected:
+  RespeakerXVF3800 *parent_;
+};
+
+template<typename... Ts> class RespeakerXVF3800StopCaptureAction : public Action<Ts...> {
+ public:
+  RespeakerXVF3800StopCaptureAction(RespeakerXVF3800 *parent) : parent_(parent) {}
+  void play(Ts... x) override { this->parent_->stop_capture(); }
+
+ protected:
+  RespeakerXVF3800 *parent_;
+};
+
+template<typename... Ts> class RespeakerXVF3800ExportCaptureAction : public Action<Ts...> {
+ public:
+  RespeakerXVF3800ExportCaptureAction(RespeakerXVF3800 *parent) : parent_(parent) {}
+  void play(Ts... x) override { this->parent_->export_capture(); }
+
+ protected:
+  RespeakerXVF3800 *parent_;
+};
+
+template<typename... Ts> class RespeakerXVF3800ReportFalseWakeAction : public Action<Ts...> {
+ public:
+  RespeakerXVF3800ReportFalseWakeAction(RespeakerXVF3800 *parent) : parent_(parent) {}
+  void play(Ts... x) override { this->parent_->report_false_wake(); }
+
+ protected:
+  RespeakerXVF3800 *parent_;
+};
+
+template<typename... Ts> class RespeakerXVF3800ClearLearnedExclusionsAction : public Action<Ts...> {
+ public:
+  RespeakerXVF3800ClearLearnedExclusionsAction(RespeakerXVF3800 *parent) : parent_(parent) {}
+  void play(Ts... x) override { this->parent_->clear_learned_exclusions(); }
+
+ protected:
+  RespeakerXVF3800 *parent_;
+};
+
+template<typename... Ts> class RespeakerXVF3800WakeExcludedCondition : public Condition<Ts...> {
+ public:
+  RespeakerXVF3800WakeExcludedCondition(RespeakerXVF3800 *parent) : parent_(parent) {}
+  bool check(Ts... x) override { return this->parent_->is_wake_excluded(millis()); }
+
+ protected:
+  RespeakerXVF3800 *parent_;
+};
+
+
+template<typename... Ts> class RespeakerXVF3800DumpTraceAction : public Action<Ts...> {
+ public:
+  RespeakerXVF3800DumpTraceAction(RespeakerXVF3800 *parent) : parent_(parent) {}
+  void play(Ts... x) override { this->parent_->dump_trace(); }
 
  protected:
   RespeakerXVF3800 *parent_;
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// No ESPHome dependencies: misc/capture_replay.cpp runs recorded captures through the same code on a host.
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+// Azimuth slot (cmd 75) the LED ring follows: beam 1, the pinned fixed beam, while the beam
+// is locked, otherwise the auto-select beam
+inline uint8_t tracked_beam_slot(bool beam_locked) { return beam_locked ? 0 : 3; }
+
+// Maps an AEC azimuth (radians) to the nearest of the 12 LEDs
+inline int led_index_for_azimuth(float radians) {
+  float degrees = radians * 180.0f / (float) M_PI;
+
+  // Map degrees to LED index (0-11). Each LED covers 30 degrees.
+  int led_index = (int) roundf(degrees / 30.0f);
+  if (led_index < 0) {
+    led_index += 12;
+  }
+  return led_index % 12;
+}
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
@@ -0,0 +1,91 @@
+#include "bus_scheduler.h"
+
+#include "esphome/core/hal.h"
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+static const uint32_t BUS_WINDOW_MS = 100;
+
+const char *bus_class_to_string(BusClass bus_class) {
+  switch (bus_class) {
+    case BUS_CLASS_CONTROL:
+      return "control";
+    case BUS_CLASS_AUDIO:
+      return "audio";
+    case BUS_CLASS_LED:
+      return "led";
+    case BUS_CLASS_TELEMETRY:
+      return "telemetry";
+    case BUS_CLASS_DFU:
+      return "dfu";
+    default:
+      return "unknown";
+  }
+}
+
+bool BusScheduler::admit(BusClass bus_class, size_t bytes) {
+  for (uint8_t higher = 0; higher < bus_class; higher++) {
+    if (this->queued_[higher].load(std::memory_order_relaxed) > 0) {
+      this->report_deferred_[bus_class]++;
+      return false;
+    }
+  }
+
+  const uint8_t budget = this->budget_percent_[bus_class];
+  if (budget == 0) {
+    return true;
+  }
+
+  this->roll_window_(millis());
+  const uint32_t used = this->window_used_us_[bus_class].load(std::memory_order_relaxed);
+  // A class that hasn't used the bus in this window always gets one transfer,
+  // so a frame larger than the budget still makes progress.
+  if (used == 0 || used + this->transfer_time_us(bytes) <= BUS_WINDOW_MS * 10 * budget) {
+    return true;
+  }
+  this->report_deferred_[bus_class]++;
+  return false;
+}
+
+void BusScheduler::record(BusClass bus_class, size_t bytes, uint32_t duration_us) {
+  // The window is rolled by admit() on the main loop only
+  this->window_used_us_[bus_class].fetch_add(duration_us, std::memory_order_relaxed);
+  this->report_busy_us_.fetch_add(duration_us, std::memory_order_relaxed);
+  this->total_busy_us_.fetch_add(duration_us, std::memory_order_relaxed);
+  this->report_bytes_[bus_class].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+uint32_t BusScheduler::transfer_time_us(size_t bytes) const {
+  return (uint32_t) ((bytes * 9 + 2) * 1000000ULL / this->frequency_);
+}
+
+float BusScheduler::take_utilization() {
+  const uint32_t now = millis();
+  const uint32_t elapsed_ms = now - this->report_start_ms_;
+  const uint32_t busy_us = this->report_busy_us_.exchange(0, std::memory_order_relaxed);
+  float utilization = 0.0f;
+  if (elapsed_ms > 0) {
+    utilization = busy_us / (elapsed_ms * 1000.0f);
+  }
+
+  this->report_start_ms_ = now;
+  for (uint8_t i = 0; i < BUS_CLASS_COUNT; i++) {
+    this->report_bytes_[i].store(0, std::memory_order_relaxed);
+    this->report_deferred_[i] = 0;
+  }
+  return utilization > 1.0f ? 1.0f : utilization;
+}
+
+void BusScheduler::roll_window_(uint32_t now) {
+  if (now - this->window_start_ms_ < BUS_WINDOW_MS) {
+    return;
+  }
+  this->window_start_ms_ = now;
+  for (auto &used : this->window_used_us_) {
+    used.store(0, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
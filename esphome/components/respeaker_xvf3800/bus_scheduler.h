@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+// Traffic classes on the shared internal I2C bus, highest priority first.
+enum BusClass : uint8_t {
+  BUS_CLASS_CONTROL = 0,  // beam lock, mute
+  BUS_CLASS_AUDIO,        // DAC volume/clocks, audio manager configuration
+  BUS_CLASS_LED,          // LED ring frames
+  BUS_CLASS_TELEMETRY,    // periodic status polls
+  BUS_CLASS_DFU,          // firmware update blocks
+  BUS_CLASS_COUNT,
+};
+
+const char *bus_class_to_string(BusClass bus_class);
+
+// Accounts the internal I2C bus shared by the XVF3800 hub and the AIC3104. Every
+// transaction is recorded with its measured duration. Only the deferrable
+// classes, LED frames and telemetry polls, ask admit() before a transfer:
+// - with a budget they may only occupy that share of each scheduling window
+// - they are held back while a higher-priority class has transfers waiting in
+//   the control task's queue, so those go out first
+// Refused transfers are deferred by the caller (LED frames) or skipped
+// (telemetry). Control, audio and DFU transfers are never refused and run in
+// program order; without the control task nothing is ever queued, so only the
+// budgets apply.
+class BusScheduler {
+ public:
+  void set_frequency(uint32_t frequency) { this->frequency_ = frequency; }
+  uint32_t get_frequency() const { return this->frequency_; }
+  // Percent of each window the class may occupy; 0 means unlimited.
+  void set_budget(BusClass bus_class, uint8_t percent) { this->budget_percent_[bus_class] = percent; }
+  uint8_t get_budget(BusClass bus_class) const { return this->budget_percent_[bus_class]; }
+
+  // Whether a LED or telemetry transfer of `bytes` (address bytes included) may go out now.
+  bool admit(BusClass bus_class, size_t bytes);
+  // Accounts a finished transaction. Safe to call from the control task.
+  void record(BusClass bus_class, size_t bytes, uint32_t duration_us);
+  // A transfer of the class was queued for the control task / was taken off the queue by it
+  void queued(BusClass bus_class) { this->queued_[bus_class].fetch_add(1, std::memory_order_relaxed); }
+  void dequeued(BusClass bus_class) { this->queued_[bus_class].fetch_sub(1, std::memory_order_relaxed); }
+
+  // Wire time of `bytes` at the configured bus frequency (9 clocks per byte plus start/stop).
+  uint32_t transfer_time_us(size_t bytes) const;
+
+  // Busy fraction (0-1) of the bus since the previous call; starts a new report period.
+  float take_utilization();
+  uint32_t get_bytes(BusClass bus_class) const {
+    return this->report_bytes_[bus_class].load(std::memory_order_relaxed);
+  }
+  uint32_t get_deferred(BusClass bus_class) const { return this->report_deferred_[bus_class]; }
+  // Bus time used since boot; wraps, so only differences between two samples are meaningful
+  uint32_t get_total_busy_us() const { return this->total_busy_us_.load(std::memory_order_relaxed); }
+
+ protected:
+  void roll_window_(uint32_t now);
+
+  uint32_t frequency_{100000};
+  uint8_t budget_percent_[BUS_CLASS_COUNT]{};
+
+  uint32_t window_start_ms_{0};
+  // Written by record(), which may run on the control task
+  std::atomic<uint32_t> window_used_us_[BUS_CLASS_COUNT]{};
+  // Transfers waiting in the control task's queue; decremented by the control task
+  std::atomic<uint8_t> queued_[BUS_CLASS_COUNT]{};
+
+  uint32_t report_start_ms_{0};
+  std::atomic<uint32_t> report_busy_us_{0};
+  std::atomic<uint32_t> report_bytes_[BUS_CLASS_COUNT]{};
+  std::atomic<uint32_t> total_busy_us_{0};
+  uint32_t report_deferred_[BUS_CLASS_COUNT]{};
+};
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
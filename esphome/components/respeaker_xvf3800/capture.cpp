@@ -0,0 +1,39 @@
+#include "capture.h"
+
+#ifdef USE_RESPEAKER_XVF3800_CAPTURE
+
+#include "esphome/core/helpers.h"
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+bool CaptureBuffer::allocate(size_t capacity) {
+  // Prefers PSRAM, falls back to internal RAM
+  RAMAllocator<CaptureRecord> allocator(RAMAllocator<CaptureRecord>::ALLOW_FAILURE);
+  this->records_ = allocator.allocate(capacity);
+  if (this->records_ == nullptr) {
+    return false;
+  }
+  this->capacity_ = capacity;
+  this->clear();
+  return true;
+}
+
+void CaptureBuffer::push(const CaptureRecord &record) {
+  this->records_[this->head_] = record;
+  this->head_ = (this->head_ + 1) % this->capacity_;
+  if (this->count_ < this->capacity_) {
+    this->count_++;
+  } else {
+    this->overwritten_++;
+  }
+}
+
+const CaptureRecord &CaptureBuffer::at(size_t index) const {
+  return this->records_[(this->head_ + this->capacity_ - this->count_ + index) % this->capacity_];
+}
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
+
+#endif  // USE_RESPEAKER_XVF3800_CAPTURE
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_RESPEAKER_XVF3800_CAPTURE
+
+#include "capture_format.h"
+
+#include <cstddef>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+// Ring of capture records, allocated once in PSRAM when available. When full the oldest
+// records are overwritten. Main loop only.
+class CaptureBuffer {
+ public:
+  bool allocate(size_t capacity);
+  bool is_allocated() const { return this->records_ != nullptr; }
+  void clear() {
+    this->head_ = 0;
+    this->count_ = 0;
+    this->overwritten_ = 0;
+  }
+  void push(const CaptureRecord &record);
+
+  size_t size() const { return this->count_; }
+  size_t capacity() const { return this->capacity_; }
+  // Records lost to the ring wrapping since the last clear()
+  uint32_t get_overwritten() const { return this->overwritten_; }
+  // `index` 0 is the oldest record
+  const CaptureRecord &at(size_t index) const;
+
+ protected:
+  CaptureRecord *records_{nullptr};
+  size_t capacity_{0};
+  size_t head_{0};  // next slot to write
+  size_t count_{0};
+  uint32_t overwritten_{0};
+};
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
+
+#endif  // USE_RESPEAKER_XVF3800_CAPTURE
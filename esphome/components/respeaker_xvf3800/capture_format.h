@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+// No ESPHome dependencies: misc/capture_replay.cpp decodes exported captures with these definitions.
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+static const uint8_t CAPTURE_FORMAT_VERSION = 1;
+// Every export line starts with this; the replay tool ignores everything else in the log
+static const char *const CAPTURE_LINE_PREFIX = "CAPTURE ";
+
+static const uint8_t CAPTURE_FLAG_BEAM_LOCKED = 1 << 0;
+static const uint8_t CAPTURE_UNKNOWN = 0xFF;  // vnr / mute value when its read failed
+
+// One sample of the tracking inputs, stored and exported as raw little-endian bytes.
+// The status fields hold the final XMOS status of each read: 0 (CTRL_DONE) on success,
+// 1 / 0x40 when the servicer kept asking for a retry (no fresh data), 0xFF on an I2C error.
+struct CaptureRecord {
+  uint32_t timestamp_ms;
+  float azimuth[4];  // radians, cmd 75 slot order: beam 1, beam 2, free-running, auto-select
+  uint8_t vnr;
+  uint8_t mute;
+  uint8_t azimuth_status;
+  uint8_t vnr_status;
+  uint8_t mute_status;
+  uint8_t flags;
+  uint8_t reserved[2];
+};
+static_assert(sizeof(CaptureRecord) == 28, "capture export format changed; bump CAPTURE_FORMAT_VERSION");
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
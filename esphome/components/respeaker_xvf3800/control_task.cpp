@@ -0,0 +1,162 @@
+#include "control_task.h"
+
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+
+#include "esphome/core/log.h"
+
+#include <cstring>
+
+#ifndef USE_ESP32
+#include <chrono>
+#endif
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+static const char *const TAG = "respeaker_xvf3800.control";
+
+static const uint32_t CONTROL_TASK_STACK_SIZE = 4096;
+static const uint32_t CONTROL_TASK_IDLE_MS = 100;
+
+bool ControlTask::start(Executor &&executor) {
+  if (this->is_running()) {
+    return true;
+  }
+  this->executor_ = std::move(executor);
+  this->running_.store(true, std::memory_order_release);
+
+#ifdef USE_ESP32
+  if (xTaskCreate(ControlTask::task_main_, "xvf3800_ctrl", CONTROL_TASK_STACK_SIZE, this, 5, &this->task_handle_) !=
+      pdPASS) {
+    ESP_LOGE(TAG, "Failed to create control task");
+    this->running_.store(false, std::memory_order_release);
+    return false;
+  }
+#else
+  this->thread_ = std::thread([this]() { this->run_(); });
+#endif
+  return true;
+}
+
+void ControlTask::stop() {
+  if (!this->running_.exchange(false, std::memory_order_acq_rel)) {
+    return;
+  }
+#ifdef USE_ESP32
+  // The task notices running_ on its next wake-up and deletes itself
+  xTaskNotifyGive(this->task_handle_);
+  this->task_handle_ = nullptr;
+#else
+  if (this->thread_.joinable()) {
+    this->thread_.join();
+  }
+#endif
+}
+
+bool ControlTask::submit_write(BusClass bus_class, uint8_t resid, uint8_t cmd, const uint8_t *data, uint8_t len,
+                               XmosCompletion &&on_complete) {
+  if (len > CONTROL_MAX_PAYLOAD) {
+    ESP_LOGW(TAG, "Write of %u bytes exceeds the queue payload size", len);
+    return false;
+  }
+  ControlCommand *command = this->acquire_slot_();
+  if (command == nullptr) {
+    return false;
+  }
+  command->bus_class = bus_class;
+  command->read = false;
+  command->resid = resid;
+  command->cmd = cmd;
+  command->len = len;
+  if (len > 0) {
+    memcpy(command->payload(), data, len);
+  }
+  command->on_complete = std::move(on_complete);
+  this->publish_slot_();
+  return true;
+}
+
+bool ControlTask::submit_read(BusClass bus_class, uint8_t resid, uint8_t cmd, uint8_t len,
+                              XmosCompletion &&on_complete) {
+  if (len > CONTROL_MAX_PAYLOAD) {
+    ESP_LOGW(TAG, "Read of %u bytes exceeds the queue payload size", len);
+    return false;
+  }
+  ControlCommand *command = this->acquire_slot_();
+  if (command == nullptr) {
+    return false;
+  }
+  command->bus_class = bus_class;
+  command->read = true;
+  command->resid = resid;
+  command->cmd = cmd;
+  command->len = len;
+  command->on_complete = std::move(on_complete);
+  this->publish_slot_();
+  return true;
+}
+
+void ControlTask::process_completions() {
+  const uint32_t executed = this->executed_.load(std::memory_order_acquire);
+  uint32_t reaped = this->reaped_.load(std::memory_order_relaxed);
+  while (reaped != executed) {
+    ControlCommand &command = this->slots_[reaped & (CONTROL_QUEUE_SIZE - 1)];
+    if (command.on_complete) {
+      command.on_complete(command.ok, command.payload());
+      command.on_complete = nullptr;
+    }
+    reaped++;
+    this->reaped_.store(reaped, std::memory_order_release);
+  }
+}
+
+ControlCommand *ControlTask::acquire_slot_() {
+  if (!this->is_running()) {
+    return nullptr;
+  }
+  const uint32_t submitted = this->submitted_.load(std::memory_order_relaxed);
+  if (submitted - this->reaped_.load(std::memory_order_acquire) >= CONTROL_QUEUE_SIZE) {
+    ESP_LOGW(TAG, "Command queue full");
+    return nullptr;
+  }
+  return &this->slots_[submitted & (CONTROL_QUEUE_SIZE - 1)];
+}
+
+void ControlTask::publish_slot_() {
+  this->submitted_.fetch_add(1, std::memory_order_release);
+#ifdef USE_ESP32
+  xTaskNotifyGive(this->task_handle_);
+#endif
+}
+
+void ControlTask::drain_() {
+  uint32_t executed = this->executed_.load(std::memory_order_relaxed);
+  while (executed != this->submitted_.load(std::memory_order_acquire)) {
+    this->executor_(this->slots_[executed & (CONTROL_QUEUE_SIZE - 1)]);
+    executed++;
+    this->executed_.store(executed, std::memory_order_release);
+  }
+}
+
+void ControlTask::run_() {
+  while (this->is_running()) {
+    this->drain_();
+#ifdef USE_ESP32
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONTROL_TASK_IDLE_MS));
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+  }
+}
+
+#ifdef USE_ESP32
+void ControlTask::task_main_(void *arg) {
+  static_cast<ControlTask *>(arg)->run_();
+  vTaskDelete(nullptr);
+}
+#endif
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
+
+#endif  // USE_RESPEAKER_XVF3800_CONTROL_TASK
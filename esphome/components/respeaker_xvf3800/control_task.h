@@ -0,0 +1,112 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#include <cstdint>
+#include <functional>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+// Control protocol header in front of every write: resid, cmd, payload length
+static const uint8_t XMOS_HEADER_BYTES = 3;
+
+// Not an XMOS status; reported when the I2C transfer itself failed
+static const uint8_t XMOS_STATUS_I2C_ERROR = 0xFF;
+
+// Completion of a queued XMOS parameter access; `data` holds the payload of a successful read.
+// After a failed read data[0] is the last XMOS status byte (XMOS_STATUS_I2C_ERROR if the bus failed).
+using XmosCompletion = std::function<void(bool ok, const uint8_t *data)>;
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
+
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+
+#include "bus_scheduler.h"
+
+#include <atomic>
+
+#ifdef USE_ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+static const uint8_t CONTROL_QUEUE_SIZE = 16;  // must be a power of two
+static const uint8_t CONTROL_MAX_PAYLOAD = 64;
+
+// One XMOS parameter read or write. The caller fills in the request; the worker
+// fills in `ok` and the payload (for reads) before the completion runs on the main loop.
+// The payload sits behind room for the protocol header so writes go out in place.
+struct ControlCommand {
+  BusClass bus_class;
+  bool read;
+  uint8_t resid;
+  uint8_t cmd;
+  uint8_t len;
+  uint8_t frame[XMOS_HEADER_BYTES + CONTROL_MAX_PAYLOAD];
+  bool ok;
+  XmosCompletion on_complete;
+
+  uint8_t *payload() { return &this->frame[XMOS_HEADER_BYTES]; }
+};
+
+// Worker that owns the XMOS transport. Commands travel through a fixed ring of
+// slots with three monotonically increasing indices:
+//   submitted_ - advanced by the main loop when it queues a command
+//   executed_  - advanced by the worker after running it
+//   reaped_    - advanced by the main loop after running its completion
+// Each index has exactly one writer, so the ring needs no locks and no heap
+// allocations after start(). All producers (lambdas, child pollers, loop()) run
+// on the main loop, which makes both directions single-producer/single-consumer.
+class ControlTask {
+ public:
+  using Executor = std::function<void(ControlCommand &)>;
+
+  ~ControlTask() { this->stop(); }
+
+  bool start(Executor &&executor);
+  void stop();
+  bool is_running() const { return this->running_.load(std::memory_order_acquire); }
+
+  // Main loop only. Return false when the ring is full.
+  bool submit_write(BusClass bus_class, uint8_t resid, uint8_t cmd, const uint8_t *data, uint8_t len,
+                    XmosCompletion &&on_complete);
+  bool submit_read(BusClass bus_class, uint8_t resid, uint8_t cmd, uint8_t len, XmosCompletion &&on_complete);
+  // Runs the completions of all executed commands; call from loop().
+  void process_completions();
+
+  uint32_t get_pending() const {
+    return this->submitted_.load(std::memory_order_relaxed) - this->reaped_.load(std::memory_order_relaxed);
+  }
+
+ protected:
+  ControlCommand *acquire_slot_();
+  void publish_slot_();
+  void run_();
+  void drain_();
+
+  ControlCommand slots_[CONTROL_QUEUE_SIZE];
+  std::atomic<uint32_t> submitted_{0};
+  std::atomic<uint32_t> executed_{0};
+  std::atomic<uint32_t> reaped_{0};
+  std::atomic<bool> running_{false};
+  Executor executor_;
+
+#ifdef USE_ESP32
+  static void task_main_(void *arg);
+  TaskHandle_t task_handle_{nullptr};
+#else
+  std::thread thread_;
+#endif
+};
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
+
+#endif  // USE_RESPEAKER_XVF3800_CONTROL_TASK
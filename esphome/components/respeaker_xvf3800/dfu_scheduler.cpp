@@ -0,0 +1,62 @@
+#include "dfu_scheduler.h"
+
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+static const uint16_t MINUTES_PER_DAY = 24 * 60;
+
+void DfuScheduler::request(uint32_t now) {
+  if (this->pending_) {
+    return;  // keeps the original request time for the maximum deferral
+  }
+  this->pending_ = true;
+  this->requested_ms_ = now;
+  this->quiet_ = false;
+}
+
+void DfuScheduler::add_vnr(bool ok, uint8_t vnr, uint32_t now) {
+  if (!ok || vnr > this->quiet_max_vnr_) {
+    this->quiet_ = false;
+  } else if (!this->quiet_) {
+    this->quiet_ = true;
+    this->quiet_since_ms_ = now;
+  }
+}
+
+const char *DfuScheduler::check(uint32_t now, int minute_of_day, bool session_active, uint32_t estimate_ms) const {
+  if (!this->pending_) {
+    return nullptr;
+  }
+  if (session_active) {
+    return nullptr;
+  }
+  if (this->max_defer_ms_ > 0 && now - this->requested_ms_ >= this->max_defer_ms_) {
+    return "maximum deferral reached";
+  }
+  if (this->has_window_ && minute_of_day >= 0 && this->in_window_(minute_of_day, estimate_ms)) {
+    return "quiet window";
+  }
+  if (this->has_quiet_vnr_ && this->quiet_ && now - this->quiet_since_ms_ >= this->quiet_hold_ms_) {
+    return "sustained low VNR";
+  }
+  return nullptr;
+}
+
+bool DfuScheduler::in_window_(int minute_of_day, uint32_t estimate_ms) const {
+  // Minutes left in the window, counted from its start so a window past midnight needs no special case
+  const uint16_t length = (this->window_end_ + MINUTES_PER_DAY - this->window_start_) % MINUTES_PER_DAY;
+  const uint16_t offset = (minute_of_day + MINUTES_PER_DAY - this->window_start_) % MINUTES_PER_DAY;
+  if (offset >= length) {
+    return false;
+  }
+  // Rounded up: an update that would run past the end waits for the next window
+  const uint32_t estimate_minutes = (estimate_ms + 59999) / 60000;
+  return offset + estimate_minutes <= length;
+}
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
+
+#endif  // USE_RESPEAKER_XVF3800_DFU_SCHEDULE
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+
+#include <cstdint>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+// Decides when a pending firmware update may take the microphone array down. An update starts
+// inside the quiet window if it can finish there, or once VNR stayed at or below the quiet
+// threshold for the configured time. A maximum deferral bounds how long a fleet may run mixed
+// firmware. Nothing starts while a voice assistant session runs. Main loop only.
+class DfuScheduler {
+ public:
+  // Minutes since midnight; the window may wrap past midnight
+  void set_window(uint16_t start_minute, uint16_t end_minute) {
+    this->window_start_ = start_minute;
+    this->window_end_ = end_minute;
+    this->has_window_ = true;
+  }
+  void set_quiet_vnr(uint8_t max_vnr, uint32_t hold_ms) {
+    this->quiet_max_vnr_ = max_vnr;
+    this->quiet_hold_ms_ = hold_ms;
+    this->has_quiet_vnr_ = true;
+  }
+  bool has_quiet_vnr() const { return this->has_quiet_vnr_; }
+  // 0 defers without limit
+  void set_max_defer(uint32_t ms) { this->max_defer_ms_ = ms; }
+
+  void request(uint32_t now);
+  void cancel() { this->pending_ = false; }
+  bool is_pending() const { return this->pending_; }
+
+  // Feeds one VNR reading; a failed read counts as not quiet
+  void add_vnr(bool ok, uint8_t vnr, uint32_t now);
+
+  // Returns why the update may start now, or nullptr to keep waiting. `minute_of_day` is -1
+  // while the time is unknown; `estimate_ms` is the expected duration of the update.
+  const char *check(uint32_t now, int minute_of_day, bool session_active, uint32_t estimate_ms) const;
+
+ protected:
+  bool in_window_(int minute_of_day, uint32_t estimate_ms) const;
+
+  bool pending_{false};
+  uint32_t requested_ms_{0};
+  uint32_t max_defer_ms_{0};
+
+  bool has_window_{false};
+  uint16_t window_start_{0};
+  uint16_t window_end_{0};
+
+  bool has_quiet_vnr_{false};
+  uint8_t quiet_max_vnr_{0};
+  uint32_t quiet_hold_ms_{0};
+  bool quiet_{false};
+  uint32_t quiet_since_ms_{0};
+};
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
+
+#endif  // USE_RESPEAKER_XVF3800_DFU_SCHEDULE
@@ -0,0 +1,91 @@
+#include "exclusion_zones.h"
+
+#ifdef USE_RESPEAKER_XVF3800_EXCLUSION_ZONES
+
+#include <cmath>
+#include <cstring>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+static const int BIN_DEGREES = 360 / EXCLUSION_BINS;
+
+void ExclusionZones::add_sample(uint32_t now, float radians) {
+  this->history_[this->history_head_] = {now, radians};
+  this->history_head_ = (this->history_head_ + 1) % EXCLUSION_HISTORY;
+  if (this->history_count_ < EXCLUSION_HISTORY) {
+    this->history_count_++;
+  }
+}
+
+int ExclusionZones::direction_at(uint32_t wake_ms) const {
+  float x = 0.0f;
+  float y = 0.0f;
+  for (uint8_t i = 0; i < this->history_count_; i++) {
+    const Sample &sample = this->history_[i];
+    const uint32_t age = wake_ms - sample.timestamp;
+    // Wraps to a large age for samples after the wake
+    if (age > this->window_ms_) {
+      continue;
+    }
+    x += cosf(sample.radians);
+    y += sinf(sample.radians);
+  }
+  if (x == 0.0f && y == 0.0f) {
+    return -1;
+  }
+  int degrees = (int) lroundf(atan2f(y, x) * 180.0f / (float) M_PI);
+  return (degrees + 360) % 360;
+}
+
+bool ExclusionZones::is_excluded(int degrees, uint32_t now) {
+  if (degrees < 0) {
+    return false;  // unknown direction: let the wake through
+  }
+  for (const Zone &zone : this->zones_) {
+    const bool inside = zone.from <= zone.to ? degrees >= zone.from && degrees <= zone.to
+                                             : degrees >= zone.from || degrees <= zone.to;
+    if (inside) {
+      return true;
+    }
+  }
+  return this->is_learning() && this->learned_weight(degrees, now) >= this->learn_threshold_;
+}
+
+bool ExclusionZones::learn(int degrees, uint32_t now) {
+  if (degrees < 0 || !this->is_learning()) {
+    return false;
+  }
+  const bool was_excluded = this->learned_weight(degrees, now) >= this->learn_threshold_;
+  this->histogram_.weight[degrees / BIN_DEGREES] += 1.0f;
+  return !was_excluded && this->learned_weight(degrees, now) >= this->learn_threshold_;
+}
+
+void ExclusionZones::clear_learned() { memset(&this->histogram_, 0, sizeof(this->histogram_)); }
+
+float ExclusionZones::learned_weight(int degrees, uint32_t now) {
+  this->decay_(now);
+  // Half of each neighbour counts, so a source on a bin edge is not split in two
+  const int bin = degrees / BIN_DEGREES;
+  const float *weight = this->histogram_.weight;
+  return weight[bin] +
+         0.5f * (weight[(bin + EXCLUSION_BINS - 1) % EXCLUSION_BINS] + weight[(bin + 1) % EXCLUSION_BINS]);
+}
+
+void ExclusionZones::decay_(uint32_t now) {
+  const uint32_t elapsed = now - this->decayed_ms_;
+  // At most every 1/64 half-life, so a wake check rarely pays for the exp2f
+  if (this->half_life_ms_ == 0 || elapsed < this->half_life_ms_ / 64) {
+    return;
+  }
+  const float factor = exp2f(-(float) elapsed / (float) this->half_life_ms_);
+  for (float &weight : this->histogram_.weight) {
+    weight *= factor;
+  }
+  this->decayed_ms_ = now;
+}
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
+
+#endif  // USE_RESPEAKER_XVF3800_EXCLUSION_ZONES
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_RESPEAKER_XVF3800_EXCLUSION_ZONES
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+static const uint8_t EXCLUSION_HISTORY = 32;  // direction samples kept for wake lookups
+static const uint8_t EXCLUSION_BINS = 36;     // learned histogram, 10 degrees per bin
+
+// Learned false-wake weights, persisted as they are
+struct ExclusionHistogram {
+  float weight[EXCLUSION_BINS];
+};
+
+// Answers whether a wake word came from a direction that should be ignored, such as a TV.
+// Directions are sampled from the auto-select beam; the direction of a wake is the circular
+// mean of the samples in the window before it. Zones are fixed angular ranges or histogram
+// bins where reported false wakes accumulated; learned weights halve every half-life, so a
+// moved noise source is forgotten. Main loop only.
+class ExclusionZones {
+ public:
+  // Degrees in the array frame; the range may wrap past 0
+  void add_zone(uint16_t from_degrees, uint16_t to_degrees) { this->zones_.push_back({from_degrees, to_degrees}); }
+  void set_window(uint32_t window_ms) { this->window_ms_ = window_ms; }
+  void set_learning(float threshold, uint32_t half_life_ms) {
+    this->learn_threshold_ = threshold;
+    this->half_life_ms_ = half_life_ms;
+  }
+  bool is_learning() const { return this->learn_threshold_ > 0.0f; }
+
+  void add_sample(uint32_t now, float radians);
+  // Direction in whole degrees (0-359) heard before `wake_ms`, or -1 if nothing was heard
+  int direction_at(uint32_t wake_ms) const;
+  bool is_excluded(int degrees, uint32_t now);
+  // Counts a false wake from `degrees`; returns true if that direction became excluded by it
+  bool learn(int degrees, uint32_t now);
+  void clear_learned();
+  // Smoothed weight of the bin holding `degrees`
+  float learned_weight(int degrees, uint32_t now);
+
+  ExclusionHistogram &get_histogram() { return this->histogram_; }
+  size_t zone_count() const { return this->zones_.size(); }
+
+ protected:
+  struct Zone {
+    uint16_t from;
+    uint16_t to;
+  };
+  struct Sample {
+    uint32_t timestamp;
+    float radians;
+  };
+
+  void decay_(uint32_t now);
+
+  std::vector<Zone> zones_;
+  uint32_t window_ms_{1500};
+
+  Sample history_[EXCLUSION_HISTORY]{};
+  uint8_t history_head_{0};
+  uint8_t history_count_{0};
+
+  float learn_threshold_{0.0f};  // 0 disables learning
+  uint32_t half_life_ms_{0};
+  uint32_t decayed_ms_{0};
+  ExclusionHistogram histogram_{};
+};
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
+
+#endif  // USE_RESPEAKER_XVF3800_EXCLUSION_ZONES
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// No ESPHome dependencies: misc/hot_path_benchmark.cpp times the same code on a host.
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+// Packs 12 0xRRGGBB colors into the RGB0 wire layout; returns the number of lit LEDs
+inline uint8_t pack_led_frame(const uint32_t *rgb_array, uint8_t *pixels) {
+  uint8_t lit = 0;
+  for (int i = 0; i < 12; i++) {
+    uint32_t color = rgb_array[i];
+    pixels[i * 4 + 0] = (uint8_t) (color & 0xFF);
+    pixels[i * 4 + 1] = (uint8_t) ((color >> 8) & 0xFF);
+    pixels[i * 4 + 2] = (uint8_t) ((color >> 16) & 0xFF);
+    pixels[i * 4 + 3] = 0x00;
+    lit += (color & 0xFFFFFF) != 0;
+  }
+  return lit;
+}
+
+// Copies the firmware block at `offset` (at most the image length) into `buf` and returns its
+// length. The frame buffer is reused; a short last block must not carry bytes of the previous one.
+inline uint32_t load_dfu_block(const uint8_t *image, uint32_t image_length, uint8_t *buf, uint8_t max_len,
+                               uint32_t offset) {
+  uint32_t buf_len = image_length - offset;
+  if (buf_len > max_len) {
+    buf_len = max_len;
+  }
+  memcpy(buf, &image[offset], buf_len);
+  memset(&buf[buf_len], 0, max_len - buf_len);
+  return buf_len;
+}
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
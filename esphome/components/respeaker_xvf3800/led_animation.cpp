@@ -0,0 +1,109 @@
+#include "led_animation.h"
+
+#ifdef USE_RESPEAKER_XVF3800_LED_ANIMATIONS
+
+#include <cstring>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+// Maps progress through a keyframe (0-256) through the easing curve, still 0-256
+static uint32_t ease(uint8_t easing, uint32_t t) {
+  switch (easing) {
+    case LED_EASING_EASE_IN:
+      return (t * t) >> 8;
+    case LED_EASING_EASE_OUT:
+      return 256 - (((256 - t) * (256 - t)) >> 8);
+    case LED_EASING_EASE_IN_OUT:
+      return (t * t * (768 - 2 * t)) >> 16;  // smoothstep
+    case LED_EASING_STEP:
+      return t >= 256 ? 256 : 0;
+    case LED_EASING_LINEAR:
+    default:
+      return t;
+  }
+}
+
+static uint16_t keyframe_duration(const uint8_t *keyframe) { return keyframe[1] | (keyframe[2] << 8); }
+
+void LedAnimationPlayer::add(const char *name, const uint8_t *keyframes, uint8_t keyframe_count, bool loop) {
+  uint32_t total_ms = 0;
+  for (uint8_t i = 0; i < keyframe_count; i++) {
+    total_ms += keyframe_duration(&keyframes[i * LED_KEYFRAME_BYTES]);
+  }
+  this->animations_.push_back({name, keyframes, keyframe_count, loop, total_ms});
+}
+
+bool LedAnimationPlayer::start(const char *name, uint32_t now, uint8_t brightness) {
+  for (const auto &animation : this->animations_) {
+    if (strcmp(animation.name, name) == 0) {
+      this->active_ = &animation;
+      this->start_ms_ = now;
+      this->brightness_ = brightness;
+      this->rendered_ = false;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool LedAnimationPlayer::render(uint32_t now, uint32_t *colors) {
+  const LedAnimation &animation = *this->active_;
+  uint32_t elapsed = now - this->start_ms_;
+  bool finished = false;
+  if (animation.total_ms == 0) {
+    elapsed = 0;
+    finished = !animation.loop;
+  } else if (animation.loop) {
+    elapsed %= animation.total_ms;
+  } else if (elapsed >= animation.total_ms) {
+    elapsed = animation.total_ms;
+    finished = true;
+  }
+
+  // Find the keyframe we are fading out of
+  const uint8_t *from = animation.keyframes;
+  uint8_t index = 0;
+  while (index + 1 < animation.keyframe_count && elapsed >= keyframe_duration(from)) {
+    elapsed -= keyframe_duration(from);
+    from += LED_KEYFRAME_BYTES;
+    index++;
+  }
+  const uint8_t *to = from;
+  if (index + 1 < animation.keyframe_count) {
+    to = from + LED_KEYFRAME_BYTES;
+  } else if (animation.loop) {
+    to = animation.keyframes;
+  }
+
+  const uint16_t duration = keyframe_duration(from);
+  uint32_t t = duration == 0 || elapsed >= duration ? 256 : (elapsed << 8) / duration;
+  t = ease(from[0], t);
+
+  const uint8_t *a = &from[3];
+  const uint8_t *b = &to[3];
+  const uint32_t scale = this->brightness_ + 1;
+  for (uint8_t led = 0; led < LED_RING_LEDS; led++) {
+    uint32_t color = 0;
+    for (uint8_t channel = 0; channel < 3; channel++, a++, b++) {
+      const int32_t value = *a + (((int32_t) *b - *a) * (int32_t) t) / 256;
+      color = (color << 8) | (((uint32_t) value * scale) >> 8);
+    }
+    colors[led] = color;
+  }
+
+  if (finished) {
+    this->active_ = nullptr;
+  }
+  if (this->rendered_ && memcmp(colors, this->last_colors_, sizeof(this->last_colors_)) == 0) {
+    return false;
+  }
+  memcpy(this->last_colors_, colors, sizeof(this->last_colors_));
+  this->rendered_ = true;
+  return true;
+}
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
+
+#endif  // USE_RESPEAKER_XVF3800_LED_ANIMATIONS
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#ifdef USE_RESPEAKER_XVF3800_LED_ANIMATIONS
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+static const uint8_t LED_RING_LEDS = 12;
+// Keyframe record as compiled by __init__.py: easing, duration in ms (little-endian), 12 x RGB
+static const uint8_t LED_KEYFRAME_BYTES = 3 + LED_RING_LEDS * 3;
+
+// Must match LED_EASINGS in __init__.py
+enum LedEasing : uint8_t {
+  LED_EASING_LINEAR = 0,
+  LED_EASING_EASE_IN,
+  LED_EASING_EASE_OUT,
+  LED_EASING_EASE_IN_OUT,
+  LED_EASING_STEP,  // holds the keyframe, then jumps to the next one
+};
+
+struct LedAnimation {
+  const char *name;
+  const uint8_t *keyframes;
+  uint8_t keyframe_count;
+  bool loop;
+  uint32_t total_ms;
+};
+
+// Plays keyframe animations compiled into constant tables. Each keyframe fades into the next
+// over its duration using its easing; a looping animation fades from the last keyframe back
+// into the first, a one-shot holds the last keyframe for its duration and then stops.
+// Rendering is integer-only and does not allocate.
+class LedAnimationPlayer {
+ public:
+  void add(const char *name, const uint8_t *keyframes, uint8_t keyframe_count, bool loop);
+
+  // `brightness` scales all colors, 0-255
+  bool start(const char *name, uint32_t now, uint8_t brightness);
+  void stop() { this->active_ = nullptr; }
+  bool is_playing() const { return this->active_ != nullptr; }
+  const char *get_active_name() const { return this->active_ != nullptr ? this->active_->name : nullptr; }
+  size_t size() const { return this->animations_.size(); }
+
+  // Writes the frame at `now` as 0xRRGGBB colors. Returns false if it equals the previous frame.
+  // A one-shot animation stops once its last frame was rendered.
+  bool render(uint32_t now, uint32_t *colors);
+
+ protected:
+  std::vector<LedAnimation> animations_;
+  const LedAnimation *active_{nullptr};
+  uint32_t start_ms_{0};
+  uint8_t brightness_{255};
+  bool rendered_{false};  // last_colors_ holds a frame of the active animation
+  uint32_t last_colors_[LED_RING_LEDS]{};
+};
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
+
+#endif  // USE_RESPEAKER_XVF3800_LED_ANIMATIONS
@@ -0,0 +1,96 @@
+#include "poll_table.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+uint8_t PollTable::add_read(uint8_t resid, uint8_t cmd, uint8_t length) {
+  for (size_t i = 0; i < this->reads_.size(); i++) {
+    PollRead &read = this->reads_[i];
+    if (read.resid == resid && read.cmd == cmd) {
+      read.length = std::max(read.length, length);
+      return i;
+    }
+  }
+  this->reads_.push_back({resid, cmd, length, 0, false});
+  return this->reads_.size() - 1;
+}
+
+void PollTable::add_task(uint32_t period_ms, uint32_t reads, std::function<void()> &&on_done) {
+  this->tasks_.push_back({std::max<uint32_t>(period_ms, 1), reads, 0, false, std::move(on_done)});
+}
+
+void PollTable::finalize(uint32_t min_tick_ms) {
+  uint16_t offset = 0;
+  for (auto &read : this->reads_) {
+    read.offset = offset;
+    offset += read.length;
+  }
+  this->values_.resize(offset);
+
+  uint32_t tick = 0;
+  for (const auto &task : this->tasks_) {
+    tick = std::gcd(tick, task.period);
+  }
+  if (tick < min_tick_ms) {
+    // Periods without a usable common divisor snap to a grid of the fastest one
+    tick = this->tasks_.empty() ? min_tick_ms : this->tasks_.front().period;
+    for (const auto &task : this->tasks_) {
+      tick = std::min(tick, task.period);
+    }
+    tick = std::max(tick, min_tick_ms);
+  }
+  this->tick_ms_ = tick;
+  for (auto &task : this->tasks_) {
+    task.period = std::max<uint32_t>((task.period + tick / 2) / tick, 1);
+  }
+}
+
+uint32_t PollTable::advance() {
+  this->now_++;
+  uint32_t reads = 0;
+  for (const auto &task : this->tasks_) {
+    if (task.next <= this->now_) {
+      reads |= task.reads;
+    }
+  }
+  return reads;
+}
+
+void PollTable::start_sweep() {
+  for (auto &task : this->tasks_) {
+    if (task.next <= this->now_) {
+      task.running = true;
+      // Next multiple of the period, so a deferred sweep does not shift the task's phase
+      task.next = (this->now_ / task.period + 1) * task.period;
+    }
+  }
+}
+
+void PollTable::set_result(uint8_t read, bool ok, const uint8_t *payload) {
+  PollRead &entry = this->reads_[read];
+  entry.ok = ok;
+  if (ok) {
+    memcpy(&this->values_[entry.offset], payload, entry.length);
+  }
+}
+
+const uint8_t *PollTable::value(uint8_t read) const {
+  const PollRead &entry = this->reads_[read];
+  return entry.ok ? &this->values_[entry.offset] : nullptr;
+}
+
+void PollTable::finish_sweep() {
+  for (auto &task : this->tasks_) {
+    if (task.running) {
+      task.running = false;
+      task.on_done();
+    }
+  }
+}
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+// One XMOS parameter read shared by the poll tasks; `offset` locates its payload in the sweep buffer
+struct PollRead {
+  uint8_t resid;
+  uint8_t cmd;
+  uint8_t length;
+  uint16_t offset;
+  bool ok;
+};
+
+// Scheduling table for the hub's periodic child entities. Every task runs on one tick, at a
+// multiple of it, so tasks with the same period (or multiples of each other) come due on the
+// same tick. All reads the due tasks need go out as one sweep, and a read several tasks share
+// goes out once. Main loop only.
+class PollTable {
+ public:
+  // Read sets are bit masks
+  static const size_t MAX_READS = 32;
+
+  // Returns the read's index. A (resid, cmd) already in the table is shared and grows to the
+  // longest length requested.
+  uint8_t add_read(uint8_t resid, uint8_t cmd, uint8_t length);
+  // `reads` is a mask of read indexes; `on_done` runs once the sweep carrying them completed
+  void add_task(uint32_t period_ms, uint32_t reads, std::function<void()> &&on_done);
+  // Sets the tick to the GCD of the task periods (at least `min_tick_ms`) and rounds every
+  // period to a multiple of it. Called once, after the last add_task().
+  void finalize(uint32_t min_tick_ms);
+
+  bool empty() const { return this->tasks_.empty(); }
+  uint32_t get_tick() const { return this->tick_ms_; }
+  size_t task_count() const { return this->tasks_.size(); }
+  const std::vector<PollRead> &get_reads() const { return this->reads_; }
+
+  // Advances one tick and returns the reads the tasks now due need; 0 if none is due. Tasks
+  // stay due until start_sweep(), so a sweep deferred by the bus budget runs on a later tick.
+  uint32_t advance();
+  // Marks the due tasks as running and moves them to their next slot on the tick grid
+  void start_sweep();
+  // Stores the outcome of one read of the running sweep
+  void set_result(uint8_t read, bool ok, const uint8_t *payload);
+  // Payload of a read from the last sweep, nullptr if it failed
+  const uint8_t *value(uint8_t read) const;
+  // Runs the completions of the running tasks
+  void finish_sweep();
+
+ protected:
+  struct Task {
+    uint32_t period;  // ticks after finalize()
+    uint32_t reads;
+    uint32_t next;  // tick the task is due at
+    bool running;
+    std::function<void()> on_done;
+  };
+
+  std::vector<PollRead> reads_;
+  std::vector<Task> tasks_;
+  std::vector<uint8_t> values_;  // payloads of all reads, back to back
+  uint32_t tick_ms_{0};
+  uint32_t now_{0};  // ticks since setup
+};
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
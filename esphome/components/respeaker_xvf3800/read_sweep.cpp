@@ -0,0 +1,34 @@
+#include "read_sweep.h"
+#include "respeaker_xvf3800.h"
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+bool ReadSweep::admit(RespeakerXVF3800 *hub, BusClass bus_class, uint8_t reads, size_t payload) {
+  return hub->get_bus_scheduler()->admit(bus_class, reads * RespeakerXVF3800::read_bus_bytes(0) + payload);
+}
+
+void ReadSweep::read(RespeakerXVF3800 *hub, BusClass bus_class, uint8_t read, uint8_t resid, uint8_t cmd,
+                     uint8_t length) {
+  if (!hub->xmos_read_async(bus_class, resid, cmd, length,
+                            [this, read](bool ok, const uint8_t *data) { this->complete_(read, ok, data); })) {
+    this->fail(read);
+  }
+}
+
+void ReadSweep::fail(uint8_t read) {
+  const uint8_t status = XMOS_STATUS_I2C_ERROR;
+  this->complete_(read, false, &status);
+}
+
+void ReadSweep::complete_(uint8_t read, bool ok, const uint8_t *data) {
+  if (this->on_read_) {
+    this->on_read_(read, ok, data);
+  }
+  if (this->pending_ > 0 && --this->pending_ == 0 && this->on_done_) {
+    this->on_done_();
+  }
+}
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
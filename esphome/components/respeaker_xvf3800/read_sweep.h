@@ -0,0 +1,49 @@
+#pragma once
+
+#include "bus_scheduler.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+class RespeakerXVF3800;
+
+// A batch of async XMOS reads whose results are used together: one publish, one capture record,
+// one calibration sample. Every read reports to `on_read`, also one that could not be queued,
+// and `on_done` runs once, after the last of them. Main loop only.
+class ReadSweep {
+ public:
+  using ReadHandler = std::function<void(uint8_t read, bool ok, const uint8_t *data)>;
+
+  // Set once, before the first sweep
+  void set_handlers(ReadHandler &&on_read, std::function<void()> &&on_done) {
+    this->on_read_ = std::move(on_read);
+    this->on_done_ = std::move(on_done);
+  }
+
+  bool is_running() const { return this->pending_ > 0; }
+  // Asks `hub`'s bus scheduler for `reads` reads carrying `payload` bytes in total, all or
+  // nothing, so the results of a sweep see the same moment
+  static bool admit(RespeakerXVF3800 *hub, BusClass bus_class, uint8_t reads, size_t payload);
+  // Starts a sweep of `reads` reads. Counted up front so a read completing inline cannot finish
+  // the sweep before the others are queued.
+  void begin(uint8_t reads) { this->pending_ = reads; }
+  // Queues read number `read` of the sweep on `hub`. A read the hub refuses is reported failed
+  // right away, with XMOS_STATUS_I2C_ERROR as its status byte.
+  void read(RespeakerXVF3800 *hub, BusClass bus_class, uint8_t read, uint8_t resid, uint8_t cmd, uint8_t length);
+  // Reports read number `read` failed without going to the bus
+  void fail(uint8_t read);
+
+ protected:
+  void complete_(uint8_t read, bool ok, const uint8_t *data);
+
+  ReadHandler on_read_;
+  std::function<void()> on_done_;
+  uint8_t pending_{0};  // reads of the current sweep not completed yet
+};
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
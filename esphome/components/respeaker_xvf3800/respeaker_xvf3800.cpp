@@ -7,35 +7,139 @@
 #include "esphome/core/log.h"
 #include "esphome/core/hal.h"
 
+#include <algorithm>
 #include <cinttypes>
+#include <cmath>
+#include <cstdlib>
 
 namespace esphome {
 namespace respeaker_xvf3800 {
 
 static const char *const TAG = "respeaker_xvf3800";
 
+#ifdef USE_RESPEAKER_XVF3800_TRACE
+#define XVF3800_TRACE(hub, type, resid, cmd, status, duration_us, value) \
+  (hub)->get_trace()->record(type, resid, cmd, status, duration_us, value)
+#else
+#define XVF3800_TRACE(hub, type, resid, cmd, status, duration_us, value)
+#endif
+
 void RespeakerXVF3800::setup() {
   ESP_LOGCONFIG(TAG, "Setting up RespeakerXVF3800...");
 
+  if (this->reset_pin_ != nullptr) {
+    this->reset_pin_->setup();
+    this->reset_pin_->digital_write(true);  // out of reset
+  }
+
   uint8_t test_data;
-  i2c::ErrorCode err = this->read(&test_data, 1);
+  i2c::ErrorCode err = this->bus_read_(BUS_CLASS_CONTROL, &test_data, 1);
   if (err != i2c::ERROR_OK) {
     ESP_LOGE(TAG, "Could not communicate with XVF3800 at configured I2C address");
     this->mark_failed();
     return;
   }
 
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+  if (!this->control_task_.start([this](ControlCommand &command) { this->execute_control_command_(command); })) {
+    ESP_LOGW(TAG, "Control task unavailable; running XMOS commands on the main loop");
+  }
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_AEC_CALIBRATION
+  // Hubs on separate buses may share an address; the first one keeps the original key
+  this->aec_delay_pref_ = global_preferences->make_preference<int32_t>(
+      fnv1_hash("respeaker_xvf3800_aec_delay") ^ this->address_ ^ (this->instance_index_ << 8));
+  this->aec_delay_valid_ = this->aec_delay_pref_.load(&this->aec_delay_);
+  this->calibration_reads_.set_handlers(
+      [this](uint8_t read, bool ok, const uint8_t *data) { this->calibration_read_(read, ok, data); },
+      [this]() { this->record_calibration_sample_(); });
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_DFU
+  this->dfu_fallback_pref_ = global_preferences->make_preference<uint32_t>(
+      fnv1_hash("respeaker_xvf3800_dfu_fallback") ^ this->address_ ^ (this->instance_index_ << 8));
+  if (!this->dfu_fallback_pref_.load(&this->dfu_fallback_image_)) {
+    this->dfu_fallback_image_ = 0;
+  }
+#endif
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+  this->dfu_rate_pref_ = global_preferences->make_preference<uint32_t>(
+      fnv1_hash("respeaker_xvf3800_dfu_rate") ^ this->address_ ^ (this->instance_index_ << 8));
+  if (!this->dfu_rate_pref_.load(&this->dfu_rate_) || this->dfu_rate_ == 0) {
+    this->dfu_rate_ = DFU_DEFAULT_BYTES_PER_S;
+  }
+#endif
+
+  if (this->bus_report_interval_ > 0) {
+    this->set_interval("bus_utilization", this->bus_report_interval_, [this]() { this->publish_bus_utilization_(); });
+  }
+#ifdef USE_RESPEAKER_XVF3800_TELEMETRY
+  this->telemetry_last_ms_ = millis();
+  this->telemetry_reads_.set_handlers(
+      [this](uint8_t read, bool ok, const uint8_t *data) { this->telemetry_read_(read, ok, data); },
+      [this]() { this->publish_telemetry_(); });
+  this->set_interval("telemetry", this->telemetry_interval_, [this]() { this->telemetry_sweep_(); });
+#endif
+#ifdef USE_RESPEAKER_XVF3800_EXCLUSION_ZONES
+  if (this->exclusion_zones_.is_learning()) {
+    this->exclusion_pref_ = global_preferences->make_preference<ExclusionHistogram>(
+        fnv1_hash("respeaker_xvf3800_exclusions") ^ this->address_ ^ (this->instance_index_ << 8));
+    this->exclusion_pref_.load(&this->exclusion_zones_.get_histogram());
+  }
+#endif
+  this->setup_poll_table_();
+#ifdef USE_RESPEAKER_XVF3800_DSP_DIAGNOSTICS
+  this->dsp_diagnostic_reads_.set_handlers(
+      [this](uint8_t read, bool ok, const uint8_t *data) { this->dsp_read_(read, ok, data); },
+      [this]() { this->publish_dsp_diagnostics_(); });
+  this->set_interval("dsp_diagnostics", this->dsp_interval_, [this]() { this->dsp_diagnostics_sweep_(); });
+#endif
+#ifdef USE_RESPEAKER_XVF3800_CAPTURE
+  if (!this->capture_.allocate(this->capture_capacity_)) {
+    ESP_LOGE(TAG, "Could not allocate %" PRIu32 " capture records", this->capture_capacity_);
+  }
+  this->capture_reads_.set_handlers(
+      [this](uint8_t read, bool ok, const uint8_t *data) { this->capture_read_(read, ok, data); },
+      [this]() {
+        if (this->capture_running_) {
+          this->capture_.push(this->capture_record_);
+        }
+      });
+#endif
+
   // Wait for XMOS to boot...
   this->set_timeout(3000, [this]() {
     if (!this->dfu_get_version_()) {
       ESP_LOGE(TAG, "Communication with Respeaker XVF3800 failed");
       this->mark_failed();
+#ifdef USE_RESPEAKER_XVF3800_DFU
+    } else if (!this->versions_match_() && this->firmware_bin_is_valid_() &&
+               this->dfu_fallback_image_ == fnv1_hash(this->firmware_bin_md5_)) {
+      // This image already failed and the XMOS fell back; flashing it again would fail the same way
+      ESP_LOGW(TAG, "Image %s fell back to the factory image before; staying on %u.%u.%u", this->firmware_bin_md5_,
+               this->firmware_version_major_, this->firmware_version_minor_, this->firmware_version_patch_);
+      this->dfu_fell_back_ = true;
+      this->apply_audio_config_();
+      this->health_armed_ = true;
     } else if (!this->versions_match_() && this->firmware_bin_is_valid_()) {
-      ESP_LOGW(TAG, "Expected XMOS version: %u.%u.%u; found: %u.%u.%u. Updating...", this->firmware_bin_version_major_,
+      ESP_LOGW(TAG, "Expected XMOS version: %u.%u.%u; found: %u.%u.%u", this->firmware_bin_version_major_,
                this->firmware_bin_version_minor_, this->firmware_bin_version_patch_, this->firmware_version_major_,
                this->firmware_version_minor_, this->firmware_version_patch_);
-      this->start_dfu_update();
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+      // The current firmware keeps serving until the schedule starts the update
+      this->apply_audio_config_();
+#endif
+      this->request_dfu_update();
+      this->health_armed_ = true;
+#endif
+    } else {
+      this->apply_audio_config_();
+      this->health_armed_ = true;
     }
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+    this->publish_dfu_schedule_();
+#endif
   });
 }
 
@@ -43,20 +147,162 @@ void RespeakerXVF3800::dump_config() {
   ESP_LOGCONFIG(TAG, "Respeaker XVF3800:");
   LOG_I2C_DEVICE(this);
   LOG_PIN("  Reset Pin: ", this->reset_pin_);
+  ESP_LOGCONFIG(TAG, "  Health: %u consecutive failures, slow above %" PRIu32 "us, %" PRIu32 " recoveries",
+                this->health_max_failures_, this->health_max_latency_us_, this->health_recoveries_);
+  ESP_LOGCONFIG(TAG, "  Bus: %" PRIu32 " Hz, budgets led=%u%% telemetry=%u%% dfu=%u%%",
+                this->bus_scheduler_.get_frequency(), this->bus_scheduler_.get_budget(BUS_CLASS_LED),
+                this->bus_scheduler_.get_budget(BUS_CLASS_TELEMETRY), this->bus_scheduler_.get_budget(BUS_CLASS_DFU));
+  LOG_SENSOR("  ", "Bus Utilization", this->bus_utilization_sensor_);
+  if (!this->poll_table_.empty()) {
+    ESP_LOGCONFIG(TAG, "  Poll table: %u tasks, %u reads, tick %" PRIu32 "ms",
+                  (unsigned) this->poll_table_.task_count(), (unsigned) this->poll_table_.get_reads().size(),
+                  this->poll_table_.get_tick());
+  }
+#ifdef USE_RESPEAKER_XVF3800_MUTE_SWITCH
+  LOG_SWITCH("  ", "Mute Switch", this->mute_switch_);
+#endif
+#ifdef USE_RESPEAKER_XVF3800_DFU_VERSION
+  LOG_TEXT_SENSOR("  ", "DFU Version", this->dfu_version_sensor_);
+#endif
+#ifdef USE_RESPEAKER_XVF3800_LED_BEAM_SENSOR
+  LOG_SENSOR("  ", "LED Beam Direction", this->led_beam_sensor_);
+#endif
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+  ESP_LOGCONFIG(TAG, "  Update schedule: estimated %" PRIu32 "s at %" PRIu32 " B/s",
+                this->get_update_estimate_ms() / 1000, this->dfu_rate_);
+  LOG_BINARY_SENSOR("  ", "Update Pending", this->update_pending_sensor_);
+  LOG_SENSOR("  ", "Update Duration", this->update_duration_sensor_);
+#endif
+#ifdef USE_RESPEAKER_XVF3800_LED_ANIMATIONS
+  ESP_LOGCONFIG(TAG, "  LED animations: %u, frame every %" PRIu32 "ms", (unsigned) this->led_animations_.size(),
+                this->led_animation_interval_);
+#endif
+#ifdef USE_RESPEAKER_XVF3800_TELEMETRY
+  LOG_TEXT_SENSOR("  ", "Telemetry", this->telemetry_sensor_);
+  ESP_LOGCONFIG(TAG, "    Interval: %" PRIu32 "ms", this->telemetry_interval_);
+#endif
+#ifdef USE_RESPEAKER_XVF3800_VNR
+  ESP_LOGCONFIG(TAG, "  VNR: every %" PRIu32 "ms, voice activity on >= %u for %" PRIu32 "ms, off < %u for %" PRIu32
+                "ms", this->vnr_interval_, this->vad_on_threshold_, this->vad_attack_ms_, this->vad_off_threshold_,
+                this->vad_release_ms_);
+  LOG_SENSOR("  ", "VNR", this->vnr_sensor_);
+#ifdef USE_BINARY_SENSOR
+  LOG_BINARY_SENSOR("  ", "Voice Activity", this->voice_activity_sensor_);
+#endif
+#endif
+#ifdef USE_RESPEAKER_XVF3800_BEAM_ENERGY
+  ESP_LOGCONFIG(TAG, "  Beam energy: every %" PRIu32 "ms, effect range %.0f..%.0f dB", this->beam_energy_interval_,
+                this->beam_energy_min_db_, this->beam_energy_max_db_);
+  LOG_SENSOR("  ", "Beam 1 Energy", this->beam_energy_sensors_[0]);
+  LOG_SENSOR("  ", "Beam 2 Energy", this->beam_energy_sensors_[1]);
+  LOG_SENSOR("  ", "Free-running Beam Energy", this->beam_energy_sensors_[2]);
+  LOG_SENSOR("  ", "Auto-select Beam Energy", this->beam_energy_sensors_[3]);
+#endif
+#ifdef USE_RESPEAKER_XVF3800_EXCLUSION_ZONES
+  ESP_LOGCONFIG(TAG, "  Exclusion zones: %u fixed, learning %s", (unsigned) this->exclusion_zones_.zone_count(),
+                this->exclusion_zones_.is_learning() ? "on" : "off");
+#endif
+#ifdef USE_RESPEAKER_XVF3800_DSP_DIAGNOSTICS
+  ESP_LOGCONFIG(TAG, "  DSP diagnostics: %u parameters every %" PRIu32 "ms", (unsigned) this->dsp_reads_.size(),
+                this->dsp_interval_);
+  for (const auto &diagnostic : this->dsp_diagnostics_) {
+    const DspRead &read = this->dsp_reads_[diagnostic.read];
+    LOG_SENSOR("    ", "DSP Parameter", diagnostic.sensor);
+    ESP_LOGCONFIG(TAG, "      resid %u, cmd %u, byte %u", read.resid, read.cmd, diagnostic.offset);
+  }
+#endif
+#ifdef USE_RESPEAKER_XVF3800_CAPTURE
+  ESP_LOGCONFIG(TAG, "  Capture: %u of %u records, every %" PRIu32 "ms", (unsigned) this->capture_.size(),
+                (unsigned) this->capture_.capacity(), this->capture_interval_);
+#endif
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+  ESP_LOGCONFIG(TAG, "  Control task: %s", this->control_task_.is_running() ? "running" : "not running");
+#endif
   if (this->firmware_version_major_ || this->firmware_version_minor_ || this->firmware_version_patch_) {
     ESP_LOGCONFIG(TAG, "  XMOS firmware version: %u.%u.%u", this->firmware_version_major_,
                   this->firmware_version_minor_, this->firmware_version_patch_);
   }
+  if (this->output_sample_rate_ != 0) {
+    ESP_LOGCONFIG(TAG, "  Output: %" PRIu32 " Hz%s, L=%u/%u, R=%u/%u", this->output_sample_rate_,
+                  this->output_word_format_ == OUTPUT_WORD_PACKED ? " packed" : "", this->output_left_[0],
+                  this->output_left_[1], this->output_right_[0], this->output_right_[1]);
+  }
+#ifdef USE_RESPEAKER_XVF3800_AEC_CALIBRATION
+  ESP_LOGCONFIG(TAG, "  AEC calibration: %" PRId32 "..%" PRId32 " samples, step %" PRId32 ", dwell %" PRIu32 "ms",
+                this->calibration_min_delay_, this->calibration_max_delay_, this->calibration_step_,
+                this->calibration_dwell_ms_);
+  if (this->aec_delay_valid_) {
+    ESP_LOGCONFIG(TAG, "  AEC reference delay: %" PRId32 " samples", this->aec_delay_);
+  }
+#endif
 }
 
 void RespeakerXVF3800::loop() {
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+  this->control_task_.process_completions();
+#endif
+  this->health_loop_();
+#ifdef USE_RESPEAKER_XVF3800_CAPTURE
+  if (this->capture_exporting_) {
+    this->capture_export_step_();
+  }
+#endif
+#ifdef USE_RESPEAKER_XVF3800_LED_ANIMATIONS
+  if (this->led_animations_.is_playing() && millis() - this->led_animation_last_ms_ >= this->led_animation_interval_) {
+    this->led_animation_last_ms_ = millis();
+    uint32_t colors[LED_RING_LEDS];
+    if (this->led_animations_.render(this->led_animation_last_ms_, colors)) {
+      this->set_led_ring(colors);
+    }
+  }
+#endif
+#ifdef USE_RESPEAKER_XVF3800_LED_RING
+  if (this->led_frame_pending_ && this->is_healthy()) {
+    this->flush_led_frame_();
+  }
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_DFU
+  if (this->dfu_busy_()) {
+    this->dfu_loop_();
+    return;
+  }
+  this->dfu_loop_requester_.stop();
+#endif
+#ifdef USE_RESPEAKER_XVF3800_AEC_CALIBRATION
+  if (this->calibration_active_) {
+    this->aec_calibration_loop_();
+  }
+#endif
+}
+
+#ifdef USE_RESPEAKER_XVF3800_DFU
+void RespeakerXVF3800::dfu_loop_() {
   switch (this->dfu_update_status_) {
     case UPDATE_IN_PROGRESS:
     case UPDATE_REBOOT_PENDING:
     case UPDATE_VERIFY_NEW_VERSION:
+      // One block per loop() pass: at full loop speed, hubs updating at the same time interleave
+      // their blocks, each sending while the others program flash
+      this->dfu_loop_requester_.start();
       this->dfu_update_status_ = this->dfu_update_send_block_();
       break;
 
+    case UPDATE_RETRY_BACKOFF:
+      this->dfu_loop_requester_.stop();
+      if ((int32_t) (millis() - this->dfu_retry_at_ms_) >= 0) {
+        this->begin_dfu_update_();
+      }
+      break;
+
+    case UPDATE_FALLBACK_INVALIDATE:
+    case UPDATE_FALLBACK_MANIFEST:
+    case UPDATE_FALLBACK_REBOOT:
+    case UPDATE_FALLBACK_VERIFY:
+      this->dfu_loop_requester_.start();
+      this->dfu_update_status_ = this->dfu_fallback_step_();
+      break;
+
     case UPDATE_COMMUNICATION_ERROR:
     case UPDATE_TIMEOUT:
     case UPDATE_FAILED:
@@ -65,46 +311,721 @@ void RespeakerXVF3800::loop() {
       this->state_callback_.call(DFU_ERROR, this->bytes_written_ * 100.0f / this->firmware_bin_length_,
                                  this->dfu_update_status_);
 #endif
-      this->mark_failed();
+      this->dfu_loop_requester_.stop();
+      this->dfu_recover_();
       break;
 
     default:
-      // Normal operation - no additional logic needed here
-      // Mute state is handled by the MuteSwitch component using GPO methods
       break;
   }
 }
+#endif
 
-uint8_t RespeakerXVF3800::read_vnr() {
-  const uint8_t vnr_req[] = {CONFIGURATION_SERVICER_RESID,
-                             CONFIGURATION_SERVICER_RESID_VNR_VALUE | CONFIGURATION_COMMAND_READ_BIT, 2};
-  uint8_t vnr_resp[2];
+bool RespeakerXVF3800::read_vnr(uint8_t *vnr) {
+  // Unlike a plain write + read, this also checks the status byte
+  return this->xmos_read_bytes(CONFIGURATION_SERVICER_RESID, CONFIGURATION_SERVICER_RESID_VNR_VALUE, vnr, 1,
+                               BUS_CLASS_TELEMETRY);
+}
 
-  auto error_code = this->write(vnr_req, sizeof(vnr_req));
-  if (error_code != i2c::ERROR_OK) {
-    ESP_LOGE(TAG, "Request status failed");
-    return 0;
+#if defined(USE_RESPEAKER_XVF3800_TELEMETRY) || defined(USE_RESPEAKER_XVF3800_CAPTURE)
+void RespeakerXVF3800::read_status_(ReadSweep &sweep) {
+  sweep.begin(STATUS_READ_COUNT);
+  sweep.read(this, BUS_CLASS_TELEMETRY, STATUS_READ_AZIMUTH, AEC_SERVICER_RESID, AEC_AZIMUTH_VALUES_CMD,
+             4 * sizeof(float));
+  sweep.read(this, BUS_CLASS_TELEMETRY, STATUS_READ_VNR, CONFIGURATION_SERVICER_RESID,
+             CONFIGURATION_SERVICER_RESID_VNR_VALUE, 1);
+  sweep.read(this, BUS_CLASS_TELEMETRY, STATUS_READ_GPO, GPO_SERVICER_RESID, GPO_SERVICER_RESID_GPO_READ_VALUES,
+             GPO_GPO_READ_NUM_BYTES);
+}
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_TELEMETRY
+void RespeakerXVF3800::telemetry_sweep_() {
+  if (this->telemetry_reads_.is_running()) {
+    return;  // previous sweep still queued
   }
-  error_code = this->read(vnr_resp, sizeof(vnr_resp));
-  if (error_code != i2c::ERROR_OK) {
-    ESP_LOGE(TAG, "Failed to read VNR");
-    return 0;
+  this->telemetry_azimuth_ok_ = false;
+  this->telemetry_vnr_ok_ = false;
+  this->telemetry_gpo_ok_ = false;
+  if (!this->is_healthy() || this->dfu_busy_()) {
+    this->publish_telemetry_();  // bus fields unknown, health counters still useful
+    return;
+  }
+  if (!ReadSweep::admit(this, BUS_CLASS_TELEMETRY, STATUS_READ_COUNT, STATUS_READ_PAYLOAD)) {
+    return;
+  }
+  this->read_status_(this->telemetry_reads_);
+}
+
+void RespeakerXVF3800::telemetry_read_(uint8_t read, bool ok, const uint8_t *data) {
+  switch (read) {
+    case STATUS_READ_AZIMUTH:
+      if (ok) {
+        for (uint8_t i = 0; i < 4; i++) {
+          float radians;
+          memcpy(&radians, &data[i * sizeof(float)], sizeof(float));
+          this->telemetry_azimuth_deg_[i] = (int16_t) lroundf(radians * 180.0f / M_PI);
+        }
+      }
+      this->telemetry_azimuth_ok_ = ok;
+      break;
+    case STATUS_READ_VNR:
+      if (ok) {
+        this->telemetry_vnr_ = data[0];
+      }
+      this->telemetry_vnr_ok_ = ok;
+      break;
+    case STATUS_READ_GPO:
+      if (ok) {
+        memcpy(this->telemetry_gpo_, data, GPO_GPO_READ_NUM_BYTES);
+      }
+      this->telemetry_gpo_ok_ = ok;
+      break;
+  }
+}
+
+void RespeakerXVF3800::publish_telemetry_() {
+  const uint32_t now = millis();
+  const uint32_t busy_us = this->bus_scheduler_.get_total_busy_us();
+  const uint32_t elapsed_ms = now - this->telemetry_last_ms_;
+  const uint32_t utilization = elapsed_ms > 0 ? (busy_us - this->telemetry_busy_us_) / (elapsed_ms * 10) : 0;
+  this->telemetry_busy_us_ = busy_us;
+  this->telemetry_last_ms_ = now;
+
+  char frame[128];
+  size_t len = 0;
+  if (this->telemetry_azimuth_ok_) {
+    len += snprintf(&frame[len], sizeof(frame) - len, "a=%d,%d,%d,%d;", this->telemetry_azimuth_deg_[0],
+                    this->telemetry_azimuth_deg_[1], this->telemetry_azimuth_deg_[2], this->telemetry_azimuth_deg_[3]);
+  } else {
+    len += snprintf(&frame[len], sizeof(frame) - len, "a=-;");
+  }
+  if (this->telemetry_vnr_ok_) {
+    len += snprintf(&frame[len], sizeof(frame) - len, "v=%u;", this->telemetry_vnr_);
+  } else {
+    len += snprintf(&frame[len], sizeof(frame) - len, "v=-;");
+  }
+  if (this->telemetry_gpo_ok_) {
+    const uint8_t *gpo = this->telemetry_gpo_;
+    len += snprintf(&frame[len], sizeof(frame) - len, "m=%u;g=%02X%02X%02X%02X%02X;", gpo[1] & 0x01, gpo[0], gpo[1],
+                    gpo[2], gpo[3], gpo[4]);
+  } else {
+    len += snprintf(&frame[len], sizeof(frame) - len, "m=-;g=-;");
+  }
+  snprintf(&frame[len], sizeof(frame) - len, "l=%u;b=%" PRIu32 ",%u,%" PRIu32, this->is_beam_locked() ? 1 : 0,
+           utilization > 100 ? 100 : utilization, this->consecutive_failures_.load(std::memory_order_relaxed),
+           this->health_recoveries_);
+
+  if (this->telemetry_sensor_->state != frame) {
+    this->telemetry_sensor_->publish_state(frame);
   }
-  return vnr_resp[1];
 }
+#endif
+
+// Tasks tick faster than this only when every period is a multiple of the tick
+static const uint32_t POLL_MIN_TICK_MS = 20;
+
+void RespeakerXVF3800::setup_poll_table_() {
+  PollTable &table = this->poll_table_;
+#ifdef USE_RESPEAKER_XVF3800_MUTE_SWITCH
+  if (this->mute_switch_ != nullptr && this->mute_switch_interval_ != SCHEDULER_DONT_RUN) {
+    const uint8_t gpo =
+        table.add_read(GPO_SERVICER_RESID, GPO_SERVICER_RESID_GPO_READ_VALUES, GPO_GPO_READ_NUM_BYTES);
+    table.add_task(this->mute_switch_interval_, 1u << gpo, [this, gpo]() {
+      const uint8_t *gpo_values = this->poll_table_.value(gpo);
+      if (gpo_values == nullptr) {
+        return;
+      }
+      bool mute_state = (gpo_values[1] & 0x01) != 0;  // GPIO30
+      XVF3800_TRACE(this, TRACE_MUTE, GPO_SERVICER_RESID, GPO_SERVICER_RESID_GPO_READ_VALUES, 0, 0, mute_state);
+      if (this->mute_switch_->state != mute_state) {
+        this->mute_switch_->publish_state(mute_state);
+      }
+    });
+  }
+#endif
+#ifdef USE_RESPEAKER_XVF3800_DFU_VERSION
+  if (this->dfu_version_sensor_ != nullptr && this->dfu_version_interval_ != SCHEDULER_DONT_RUN) {
+    const uint8_t version =
+        table.add_read(DFU_CONTROLLER_SERVICER_RESID, DFU_CONTROLLER_SERVICER_RESID_DFU_GETVERSION, 3);
+    table.add_task(this->dfu_version_interval_, 1u << version, [this, version]() {
+      const uint8_t *data = this->poll_table_.value(version);
+      std::string state = data != nullptr ? str_sprintf("%u.%u.%u", data[0], data[1], data[2]) : "Unknown";
+      if (this->dfu_version_sensor_->get_raw_state() != state) {
+        this->dfu_version_sensor_->publish_state(state);
+      }
+    });
+  }
+#endif
+
+  // The consumers of cmd 75 share one azimuth read whenever they come due together
+#if defined(USE_RESPEAKER_XVF3800_LED_BEAM_SENSOR) || defined(USE_RESPEAKER_XVF3800_BEAM_ENERGY) || \
+    defined(USE_RESPEAKER_XVF3800_EXCLUSION_ZONES)
+  const uint8_t azimuth = table.add_read(AEC_SERVICER_RESID, AEC_AZIMUTH_VALUES_CMD, 4 * sizeof(float));
+#endif
+#ifdef USE_RESPEAKER_XVF3800_LED_BEAM_SENSOR
+  if (this->led_beam_sensor_ != nullptr && this->led_beam_interval_ != SCHEDULER_DONT_RUN) {
+    table.add_task(this->led_beam_interval_, 1u << azimuth, [this, azimuth]() {
+      const uint8_t *azimuths = this->poll_table_.value(azimuth);
+      if (azimuths == nullptr) {
+        return;
+      }
+      // While locked, follow beam 1 (the pinned fixed beam) instead of the auto-select beam
+      const uint8_t beam_index = tracked_beam_slot(this->is_beam_locked());
+      float radians;
+      memcpy(&radians, &azimuths[beam_index * sizeof(float)], sizeof(float));
+      int led_index = azimuth_to_led_index(radians);
+      XVF3800_TRACE(this, TRACE_AZIMUTH, AEC_SERVICER_RESID, AEC_AZIMUTH_VALUES_CMD, beam_index, 0, radians);
+      XVF3800_TRACE(this, TRACE_LED_BEAM, AEC_SERVICER_RESID, AEC_AZIMUTH_VALUES_CMD, beam_index, 0, led_index);
+      if (!this->led_beam_sensor_->has_state() || this->led_beam_sensor_->get_raw_state() != led_index) {
+        this->led_beam_sensor_->publish_state(led_index);
+      }
+    });
+  }
+#endif
+#ifdef USE_RESPEAKER_XVF3800_VNR
+  const uint8_t vnr =
+      table.add_read(CONFIGURATION_SERVICER_RESID, CONFIGURATION_SERVICER_RESID_VNR_VALUE, 1);
+  table.add_task(this->vnr_interval_, 1u << vnr, [this, vnr]() {
+    const uint8_t *data = this->poll_table_.value(vnr);
+    this->handle_vnr_(data != nullptr, data != nullptr ? data[0] : 0);
+  });
+#endif
+#ifdef USE_RESPEAKER_XVF3800_BEAM_ENERGY
+  const uint8_t energy = table.add_read(AEC_SERVICER_RESID, AEC_SPENERGY_VALUES_CMD, 4 * sizeof(float));
+  table.add_task(this->beam_energy_interval_, (1u << azimuth) | (1u << energy), [this, azimuth, energy]() {
+    // Read in the same sweep, so the LED index matches the energy
+    if (const uint8_t *azimuths = this->poll_table_.value(azimuth)) {
+      float radians;
+      memcpy(&radians, &azimuths[tracked_beam_slot(this->is_beam_locked()) * sizeof(float)], sizeof(float));
+      this->beam_energy_led_ = azimuth_to_led_index(radians);
+    }
+    if (const uint8_t *energies = this->poll_table_.value(energy)) {
+      this->handle_beam_energy_(energies);
+    }
+  });
+#endif
+#ifdef USE_RESPEAKER_XVF3800_EXCLUSION_ZONES
+  table.add_task(this->exclusion_interval_, 1u << azimuth, [this, azimuth]() {
+    if (const uint8_t *azimuths = this->poll_table_.value(azimuth)) {
+      this->add_direction_sample_(azimuths);
+    }
+  });
+#endif
+
+  if (table.empty()) {
+    return;
+  }
+  table.finalize(POLL_MIN_TICK_MS);
+  this->poll_reads_.set_handlers(
+      [this](uint8_t read, bool ok, const uint8_t *data) { this->poll_table_.set_result(read, ok, data); },
+      [this]() { this->poll_table_.finish_sweep(); });
+  this->set_interval("poll", table.get_tick(), [this]() { this->poll_sweep_(); });
+}
+
+void RespeakerXVF3800::poll_sweep_() {
+  const uint32_t due = this->poll_table_.advance();
+  if (due == 0 || this->poll_reads_.is_running() || !this->is_healthy() || this->dfu_busy_()) {
+    return;  // due tasks stay due until a sweep carries them
+  }
+  const std::vector<PollRead> &reads = this->poll_table_.get_reads();
+  size_t payload = 0;
+  uint8_t count = 0;
+  for (size_t i = 0; i < reads.size(); i++) {
+    if (due & (1u << i)) {
+      payload += reads[i].length;
+      count++;
+    }
+  }
+  if (!ReadSweep::admit(this, BUS_CLASS_TELEMETRY, count, payload)) {
+    return;
+  }
+
+  this->poll_table_.start_sweep();
+  this->poll_reads_.begin(count);
+  for (uint8_t i = 0; i < reads.size(); i++) {
+    if (due & (1u << i)) {
+      this->poll_reads_.read(this, BUS_CLASS_TELEMETRY, i, reads[i].resid, reads[i].cmd, reads[i].length);
+    }
+  }
+}
+
+#ifdef USE_RESPEAKER_XVF3800_VNR
+void RespeakerXVF3800::handle_vnr_(bool ok, uint8_t vnr) {
+  XVF3800_TRACE(this, TRACE_VNR, CONFIGURATION_SERVICER_RESID, CONFIGURATION_SERVICER_RESID_VNR_VALUE,
+                ok ? CTRL_DONE : 0xFF, 0, vnr);
+  if (!ok) {
+    // Unknown rather than 0; voice activity keeps its state until a real reading arrives
+    if (this->vnr_sensor_ != nullptr && !std::isnan(this->vnr_sensor_->state)) {
+      this->vnr_sensor_->publish_state(NAN);
+    }
+    return;
+  }
+  if (this->vnr_sensor_ != nullptr && this->vnr_sensor_->state != vnr) {
+    this->vnr_sensor_->publish_state(vnr);
+  }
+
+  // Only the threshold in the direction of a change matters; the gap between the two is the hysteresis
+  const bool crossing = this->voice_active_ ? vnr < this->vad_off_threshold_ : vnr >= this->vad_on_threshold_;
+  const uint32_t now = millis();
+  if (!crossing) {
+    this->vad_pending_ = false;
+  } else if (!this->vad_pending_) {
+    this->vad_pending_ = true;
+    this->vad_pending_since_ms_ = now;
+  }
+  if (this->vad_pending_ &&
+      now - this->vad_pending_since_ms_ >= (this->voice_active_ ? this->vad_release_ms_ : this->vad_attack_ms_)) {
+    this->voice_active_ = !this->voice_active_;
+    this->vad_pending_ = false;
+    ESP_LOGD(TAG, "Voice activity %s (VNR %u)", this->voice_active_ ? "started" : "ended", vnr);
+#ifdef USE_BINARY_SENSOR
+    if (this->voice_activity_sensor_ != nullptr) {
+      this->voice_activity_sensor_->publish_state(this->voice_active_);
+    }
+#endif
+  }
+#ifdef USE_BINARY_SENSOR
+  if (this->voice_activity_sensor_ != nullptr && !this->voice_activity_sensor_->has_state()) {
+    this->voice_activity_sensor_->publish_initial_state(this->voice_active_);
+  }
+#endif
+}
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_BEAM_ENERGY
+// Reported for silent beams instead of -inf
+static const float BEAM_ENERGY_FLOOR_DB = -120.0f;
+// Energy moves on every read; smaller changes are not published so a 100ms poll stays off the API
+static const float BEAM_ENERGY_PUBLISH_DELTA_DB = 1.0f;
+
+void RespeakerXVF3800::handle_beam_energy_(const uint8_t *energies) {
+  float levels_db[4];
+  for (uint8_t beam = 0; beam < 4; beam++) {
+    float energy;
+    memcpy(&energy, &energies[beam * sizeof(float)], sizeof(float));
+    levels_db[beam] = energy > 0.0f ? std::max(10.0f * log10f(energy), BEAM_ENERGY_FLOOR_DB) : BEAM_ENERGY_FLOOR_DB;
+
+    sensor::Sensor *sensor = this->beam_energy_sensors_[beam];
+    if (sensor != nullptr &&
+        (!sensor->has_state() || fabsf(sensor->get_raw_state() - levels_db[beam]) >= BEAM_ENERGY_PUBLISH_DELTA_DB)) {
+      sensor->publish_state(levels_db[beam]);
+    }
+  }
+
+#ifdef USE_RESPEAKER_XVF3800_LED_RING
+  if (this->energy_effect_active_) {
+    this->render_energy_effect_(levels_db[tracked_beam_slot(this->is_beam_locked())]);
+  }
+#endif
+}
+
+#ifdef USE_RESPEAKER_XVF3800_LED_RING
+void RespeakerXVF3800::render_energy_effect_(float level_db) {
+  const uint32_t now = millis();
+  float level = (level_db - this->beam_energy_min_db_) / (this->beam_energy_max_db_ - this->beam_energy_min_db_);
+  level = std::max(0.0f, std::min(level, 1.0f));
+  const float fall = this->energy_effect_release_ms_ == 0
+                         ? 1.0f
+                         : (float) (now - this->energy_effect_last_ms_) / this->energy_effect_release_ms_;
+  this->energy_effect_level_ = std::max(level, this->energy_effect_level_ - fall);
+  this->energy_effect_last_ms_ = now;
+
+#ifdef USE_RESPEAKER_XVF3800_LED_ANIMATIONS
+  if (this->led_animations_.is_playing()) {
+    return;
+  }
+#endif
+  if (this->beam_energy_led_ < 0) {
+    return;
+  }
+
+  // The arc grows from the beam LED towards the opposite side (6 LEDs away); edge LEDs fade in
+  const float span = this->energy_effect_level_ * 7.0f;
+  uint32_t colors[12];
+  for (int led = 0; led < 12; led++) {
+    int distance = abs(led - this->beam_energy_led_);
+    distance = std::min(distance, 12 - distance);
+    const float intensity = std::max(0.0f, std::min(span - distance, 1.0f));
+    const uint32_t scale = (uint32_t) (intensity * this->energy_effect_brightness_);
+    uint32_t color = 0;
+    for (int shift = 16; shift >= 0; shift -= 8) {
+      color |= (((this->energy_effect_color_ >> shift) & 0xFF) * scale / 255) << shift;
+    }
+    colors[led] = color;
+  }
+  if (memcmp(colors, this->energy_effect_frame_, sizeof(colors)) == 0) {
+    return;
+  }
+  memcpy(this->energy_effect_frame_, colors, sizeof(colors));
+  this->set_led_ring(colors);
+}
+#endif
+#endif
+
+#if defined(USE_RESPEAKER_XVF3800_BEAM_ENERGY) && defined(USE_RESPEAKER_XVF3800_LED_RING)
+void RespeakerXVF3800::start_energy_effect(float brightness) {
+  brightness = std::max(0.0f, std::min(brightness, 1.0f));
+  this->energy_effect_brightness_ = (uint8_t) roundf(brightness * 255.0f);
+  this->energy_effect_level_ = 0;
+  this->energy_effect_last_ms_ = millis();
+  this->energy_effect_frame_[0] = UINT32_MAX;  // not a color, so the first frame always goes out
+  this->energy_effect_active_ = true;
+  ESP_LOGD(TAG, "Energy LED effect started");
+}
+
+void RespeakerXVF3800::stop_energy_effect() {
+  if (!this->energy_effect_active_) {
+    return;
+  }
+  this->energy_effect_active_ = false;
+#ifdef USE_RESPEAKER_XVF3800_LED_ANIMATIONS
+  if (this->led_animations_.is_playing()) {
+    return;  // the ring belongs to the animation
+  }
+#endif
+  uint32_t off[12]{};
+  this->set_led_ring(off);
+}
+#else
+void RespeakerXVF3800::start_energy_effect(float brightness) {
+  ESP_LOGE(TAG, "Energy LED effect is not configured");
+}
+
+void RespeakerXVF3800::stop_energy_effect() {}
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_EXCLUSION_ZONES
+void RespeakerXVF3800::add_direction_sample_(const uint8_t *azimuths) {
+  // Auto-select beam; only a fresh azimuth gets here, so silence leaves no samples
+  float radians;
+  memcpy(&radians, &azimuths[3 * sizeof(float)], sizeof(float));
+  this->exclusion_zones_.add_sample(millis(), radians);
+}
+
+bool RespeakerXVF3800::is_wake_excluded(uint32_t wake_ms) {
+  const int direction = this->exclusion_zones_.direction_at(wake_ms);
+  this->last_wake_ms_ = wake_ms;
+  this->last_wake_direction_ = direction;
+  const bool excluded = this->exclusion_zones_.is_excluded(direction, millis());
+  if (excluded) {
+    ESP_LOGD(TAG, "Wake from %d deg ignored: excluded direction", direction);
+  } else {
+    ESP_LOGV(TAG, "Wake from %d deg", direction);
+  }
+  return excluded;
+}
+
+void RespeakerXVF3800::report_false_wake() {
+  if (!this->exclusion_zones_.is_learning()) {
+    ESP_LOGW(TAG, "Exclusion learning is not configured");
+    return;
+  }
+  if (this->last_wake_direction_ < 0) {
+    ESP_LOGD(TAG, "False wake without a known direction; not learned");
+    return;
+  }
+  const int direction = this->last_wake_direction_;
+  this->last_wake_direction_ = -1;  // each wake counts once
+  if (this->exclusion_zones_.learn(direction, millis())) {
+    ESP_LOGI(TAG, "Wakes from around %d deg are now ignored", direction);
+  }
+  ESP_LOGD(TAG, "False wake from %d deg, learned weight %.1f", direction,
+           this->exclusion_zones_.learned_weight(direction, millis()));
+  this->exclusion_pref_.save(&this->exclusion_zones_.get_histogram());
+}
+
+void RespeakerXVF3800::clear_learned_exclusions() {
+  if (!this->exclusion_zones_.is_learning()) {
+    return;
+  }
+  this->exclusion_zones_.clear_learned();
+  this->exclusion_pref_.save(&this->exclusion_zones_.get_histogram());
+  ESP_LOGI(TAG, "Learned exclusion zones cleared");
+}
+#else
+bool RespeakerXVF3800::is_wake_excluded(uint32_t wake_ms) { return false; }
+
+void RespeakerXVF3800::report_false_wake() { ESP_LOGE(TAG, "Exclusion zones are not configured"); }
+
+void RespeakerXVF3800::clear_learned_exclusions() {}
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_DSP_DIAGNOSTICS
+void RespeakerXVF3800::dsp_diagnostics_sweep_() {
+  if (this->dsp_diagnostic_reads_.is_running() || this->dfu_busy_()) {
+    return;
+  }
+  size_t payload = 0;
+  for (const auto &read : this->dsp_reads_) {
+    payload += read.length;
+  }
+  if (!ReadSweep::admit(this, BUS_CLASS_TELEMETRY, this->dsp_reads_.size(), payload)) {
+    return;
+  }
+
+  this->dsp_diagnostic_reads_.begin(this->dsp_reads_.size());
+  for (uint8_t i = 0; i < this->dsp_reads_.size(); i++) {
+    const DspRead &read = this->dsp_reads_[i];
+    this->dsp_diagnostic_reads_.read(this, BUS_CLASS_TELEMETRY, i, read.resid, read.cmd, read.length);
+  }
+}
+
+void RespeakerXVF3800::dsp_read_(uint8_t read, bool ok, const uint8_t *data) {
+  DspRead &entry = this->dsp_reads_[read];
+  if (ok) {
+    memcpy(&this->dsp_values_[entry.offset], data, entry.length);
+  }
+  entry.ok = ok;
+}
+
+void RespeakerXVF3800::publish_dsp_diagnostics_() {
+  for (const auto &diagnostic : this->dsp_diagnostics_) {
+    const DspRead &read = this->dsp_reads_[diagnostic.read];
+    float value = NAN;  // unknown rather than a stale value when the read failed
+    if (read.ok) {
+      const uint8_t *data = &this->dsp_values_[read.offset + diagnostic.offset];
+      switch (diagnostic.type) {
+        case DSP_VALUE_UINT8:
+          value = data[0];
+          break;
+        case DSP_VALUE_INT32: {
+          int32_t raw;
+          memcpy(&raw, data, sizeof(raw));
+          value = raw;
+          break;
+        }
+        case DSP_VALUE_UINT32: {
+          uint32_t raw;
+          memcpy(&raw, data, sizeof(raw));
+          value = raw;
+          break;
+        }
+        case DSP_VALUE_FLOAT:
+          memcpy(&value, data, sizeof(value));
+          break;
+      }
+    }
+
+    sensor::Sensor *sensor = diagnostic.sensor;
+    const float last = sensor->get_raw_state();
+    // An unchanged value is never republished, also with the default min_change of 0
+    const float change = fabsf(last - value);
+    if (!sensor->has_state() || std::isnan(last) != std::isnan(value) ||
+        (change > 0.0f && change >= diagnostic.min_change)) {
+      sensor->publish_state(value);
+    }
+  }
+}
+#endif
 
+#ifdef USE_RESPEAKER_XVF3800_CAPTURE
+static const uint8_t CAPTURE_RECORDS_PER_LINE = 4;
+// A few lines per loop pass keeps a large export from stalling the loop or flooding the log
+static const uint8_t CAPTURE_EXPORT_LINES_PER_LOOP = 4;
+
+void RespeakerXVF3800::start_capture() {
+  if (!this->capture_.is_allocated()) {
+    ESP_LOGE(TAG, "No capture buffer");
+    return;
+  }
+  this->capture_exporting_ = false;
+  this->capture_.clear();
+  this->capture_running_ = true;
+  this->set_interval("capture", this->capture_interval_, [this]() { this->capture_sample_(); });
+  ESP_LOGI(TAG, "Capture started: %u records every %" PRIu32 "ms", (unsigned) this->capture_.capacity(),
+           this->capture_interval_);
+}
+
+void RespeakerXVF3800::stop_capture() {
+  if (!this->capture_running_) {
+    return;
+  }
+  this->capture_running_ = false;
+  this->cancel_interval("capture");
+  ESP_LOGI(TAG, "Capture stopped: %u records, %" PRIu32 " overwritten", (unsigned) this->capture_.size(),
+           this->capture_.get_overwritten());
+}
+
+void RespeakerXVF3800::export_capture() {
+  // The ring must not move under the export
+  this->stop_capture();
+  ESP_LOGI(TAG, "%sv%u records=%u record_size=%u interval=%" PRIu32 " overwritten=%" PRIu32, CAPTURE_LINE_PREFIX,
+           CAPTURE_FORMAT_VERSION, (unsigned) this->capture_.size(), (unsigned) sizeof(CaptureRecord),
+           this->capture_interval_, this->capture_.get_overwritten());
+  this->capture_export_index_ = 0;
+  this->capture_exporting_ = true;
+}
+
+void RespeakerXVF3800::capture_export_step_() {
+  static const char *const HEX_DIGITS = "0123456789abcdef";
+  for (uint8_t line = 0; line < CAPTURE_EXPORT_LINES_PER_LOOP; line++) {
+    if (this->capture_export_index_ >= this->capture_.size()) {
+      ESP_LOGI(TAG, "%sEND", CAPTURE_LINE_PREFIX);
+      this->capture_exporting_ = false;
+      return;
+    }
+    char hex[CAPTURE_RECORDS_PER_LINE * sizeof(CaptureRecord) * 2 + 1];
+    size_t len = 0;
+    for (uint8_t i = 0; i < CAPTURE_RECORDS_PER_LINE && this->capture_export_index_ < this->capture_.size(); i++) {
+      const auto *bytes = reinterpret_cast<const uint8_t *>(&this->capture_.at(this->capture_export_index_++));
+      for (size_t b = 0; b < sizeof(CaptureRecord); b++) {
+        hex[len++] = HEX_DIGITS[bytes[b] >> 4];
+        hex[len++] = HEX_DIGITS[bytes[b] & 0x0F];
+      }
+    }
+    hex[len] = '\0';
+    ESP_LOGI(TAG, "%s%s", CAPTURE_LINE_PREFIX, hex);
+  }
+}
+
+void RespeakerXVF3800::capture_sample_() {
+  if (this->capture_reads_.is_running()) {
+    return;  // previous record still in flight
+  }
+  if (!ReadSweep::admit(this, BUS_CLASS_TELEMETRY, STATUS_READ_COUNT, STATUS_READ_PAYLOAD)) {
+    return;  // shows up as a gap in the timestamps
+  }
+
+  CaptureRecord &record = this->capture_record_;
+  record = {};
+  record.timestamp_ms = millis();
+  for (float &azimuth : record.azimuth) {
+    azimuth = NAN;
+  }
+  record.vnr = CAPTURE_UNKNOWN;
+  record.mute = CAPTURE_UNKNOWN;
+  record.flags = this->is_beam_locked() ? CAPTURE_FLAG_BEAM_LOCKED : 0;
+  this->read_status_(this->capture_reads_);
+}
+
+// Failed reads keep their status byte; reads the hub refused (unhealthy) show the I2C error status
+void RespeakerXVF3800::capture_read_(uint8_t read, bool ok, const uint8_t *data) {
+  CaptureRecord &record = this->capture_record_;
+  const uint8_t status = ok ? (uint8_t) CTRL_DONE : data[0];
+  switch (read) {
+    case STATUS_READ_AZIMUTH:
+      if (ok) {
+        memcpy(record.azimuth, data, sizeof(record.azimuth));
+      }
+      record.azimuth_status = status;
+      break;
+    case STATUS_READ_VNR:
+      if (ok) {
+        record.vnr = data[0];
+      }
+      record.vnr_status = status;
+      break;
+    case STATUS_READ_GPO:
+      if (ok) {
+        record.mute = data[1] & 0x01;  // GPIO30
+      }
+      record.mute_status = status;
+      break;
+  }
+}
+#else
+void RespeakerXVF3800::start_capture() { ESP_LOGE(TAG, "Capture is not configured"); }
+
+void RespeakerXVF3800::stop_capture() {}
+
+void RespeakerXVF3800::export_capture() { ESP_LOGE(TAG, "Capture is not configured"); }
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_DFU
 void RespeakerXVF3800::start_dfu_update() {
   if (this->firmware_bin_ == nullptr || !this->firmware_bin_length_) {
     ESP_LOGE(TAG, "Firmware invalid");
     return;
   }
 
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+  // Also taken when forced while a deferred update is pending
+  this->dfu_schedule_.cancel();
+  this->cancel_interval("dfu_schedule");
+  this->publish_dfu_schedule_();
+#endif
   ESP_LOGI(TAG, "Starting update from %u.%u.%u...", this->firmware_version_major_, this->firmware_version_minor_,
            this->firmware_version_patch_);
 #ifdef USE_RESPEAKER_XVF3800_STATE_CALLBACK
   this->state_callback_.call(DFU_START, 0, UPDATE_OK);
 #endif
+  this->dfu_attempts_ = 0;
+  this->dfu_fell_back_ = false;
+  this->dfu_prior_version_[0] = this->firmware_version_major_;
+  this->dfu_prior_version_[1] = this->firmware_version_minor_;
+  this->dfu_prior_version_[2] = this->firmware_version_patch_;
+  this->begin_dfu_update_();
+}
+
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+void RespeakerXVF3800::request_dfu_update() {
+  if (this->dfu_busy_()) {
+    ESP_LOGW(TAG, "Update already running");
+    return;
+  }
+  if (!this->firmware_bin_is_valid_() || this->dfu_schedule_.is_pending()) {
+    return;
+  }
+  this->dfu_schedule_.request(millis());
+  ESP_LOGI(TAG, "Update deferred until a quiet period; estimated %" PRIu32 "s", this->get_update_estimate_ms() / 1000);
+  this->set_interval("dfu_schedule", DFU_SCHEDULE_CHECK_MS, [this]() { this->dfu_schedule_check_(); });
+  this->publish_dfu_schedule_();
+}
+
+void RespeakerXVF3800::dfu_schedule_check_() {
+  const uint32_t now = millis();
+  int minute_of_day = -1;  // unknown until the clock is synced
+#ifdef USE_TIME
+  if (this->dfu_time_ != nullptr) {
+    ESPTime time = this->dfu_time_->now();
+    if (time.is_valid()) {
+      minute_of_day = time.hour * 60 + time.minute;
+    }
+  }
+#endif
+  bool session_active = false;
+#ifdef USE_VOICE_ASSISTANT
+  session_active = this->dfu_voice_assistant_ != nullptr && this->dfu_voice_assistant_->is_running();
+#endif
+  const char *reason = this->dfu_schedule_.check(now, minute_of_day, session_active, this->get_update_estimate_ms());
+  if (reason != nullptr) {
+    ESP_LOGI(TAG, "Starting deferred update: %s", reason);
+    this->start_dfu_update();
+    return;
+  }
 
+  // A skipped sample leaves the quiet period running; a failed read ends it
+  if (this->dfu_schedule_.has_quiet_vnr() && this->bus_scheduler_.admit(BUS_CLASS_TELEMETRY, read_bus_bytes(1))) {
+    if (!this->xmos_read_async(BUS_CLASS_TELEMETRY, CONFIGURATION_SERVICER_RESID,
+                               CONFIGURATION_SERVICER_RESID_VNR_VALUE, 1, [this](bool ok, const uint8_t *data) {
+                                 this->dfu_schedule_.add_vnr(ok, ok ? data[0] : 0, millis());
+                               })) {
+      this->dfu_schedule_.add_vnr(false, 0, now);
+    }
+  }
+}
+
+void RespeakerXVF3800::publish_dfu_schedule_() {
+#ifdef USE_BINARY_SENSOR
+  if (this->update_pending_sensor_ != nullptr &&
+      (!this->update_pending_sensor_->has_state() ||
+       this->update_pending_sensor_->state != this->dfu_schedule_.is_pending())) {
+    this->update_pending_sensor_->publish_state(this->dfu_schedule_.is_pending());
+  }
+#endif
+  if (this->update_duration_sensor_ != nullptr) {
+    const float seconds = roundf(this->get_update_estimate_ms() / 1000.0f);
+    if (this->update_duration_sensor_->get_raw_state() != seconds) {
+      this->update_duration_sensor_->publish_state(seconds);
+    }
+  }
+}
+#else
+void RespeakerXVF3800::request_dfu_update() { this->start_dfu_update(); }
+#endif
+
+void RespeakerXVF3800::begin_dfu_update_() {
   if (!this->dfu_set_alternate_()) {
     ESP_LOGE(TAG, "Set alternate request failed");
     this->dfu_update_status_ = UPDATE_COMMUNICATION_ERROR;
@@ -120,9 +1041,11 @@ void RespeakerXVF3800::start_dfu_update() {
 
 RespeakerXVF3800UpdaterStatus RespeakerXVF3800::dfu_update_send_block_() {
   i2c::ErrorCode error_code = i2c::NO_ERROR;
-  uint8_t dfu_dnload_req[MAX_XFER + 6] = {240, 1, 130,  // resid, cmd_id, payload length,
-                                          0, 0};        // additional payload length (set below)
-                                                        // followed by payload data with null terminator
+  // resid, cmd_id, payload length, block length (set below), reserved, followed by the block
+  uint8_t *dfu_dnload_req = this->dfu_frame_;
+  dfu_dnload_req[0] = DFU_CONTROLLER_SERVICER_RESID;
+  dfu_dnload_req[1] = DFU_CONTROLLER_SERVICER_RESID_DFU_DNLOAD;
+  dfu_dnload_req[2] = DFU_DNLOAD_FRAME_BYTES - XMOS_HEADER_BYTES;
   if (millis() > this->last_ready_ + DFU_TIMEOUT_MS) {
     ESP_LOGE(TAG, "DFU timed out");
     return UPDATE_TIMEOUT;
@@ -134,14 +1057,15 @@ RespeakerXVF3800UpdaterStatus RespeakerXVF3800::dfu_update_send_block_() {
     }
 
     // read a maximum of MAX_XFER bytes into buffer (real read size is returned)
-    auto bufsize = this->load_buf_(&dfu_dnload_req[5], MAX_XFER, this->bytes_written_);
+    auto bufsize = this->load_buf_(&dfu_dnload_req[XMOS_HEADER_BYTES + 2], MAX_XFER, this->bytes_written_);
     ESP_LOGVV(TAG, "size = %u, bytes written = %u, bufsize = %u", this->firmware_bin_length_, this->bytes_written_,
               bufsize);
 
     if (bufsize > 0 && bufsize <= MAX_XFER) {
       // write bytes to XMOS
       dfu_dnload_req[3] = (uint8_t) bufsize;
-      error_code = this->write(dfu_dnload_req, sizeof(dfu_dnload_req) - 1);
+      dfu_dnload_req[4] = 0;
+      error_code = this->bus_write_(BUS_CLASS_DFU, dfu_dnload_req, DFU_DNLOAD_FRAME_BYTES);
       if (error_code != i2c::ERROR_OK) {
         ESP_LOGE(TAG, "DFU download request failed");
         return UPDATE_COMMUNICATION_ERROR;
@@ -165,9 +1089,9 @@ RespeakerXVF3800UpdaterStatus RespeakerXVF3800::dfu_update_send_block_() {
         if (!this->dfu_check_if_ready_()) {
           return UPDATE_IN_PROGRESS;
         }
-        memset(&dfu_dnload_req[3], 0, MAX_XFER + 2);
+        memset(&dfu_dnload_req[XMOS_HEADER_BYTES], 0, DFU_DNLOAD_FRAME_BYTES - XMOS_HEADER_BYTES);
         // send empty download request to conclude DFU download
-        error_code = this->write(dfu_dnload_req, sizeof(dfu_dnload_req) - 1);
+        error_code = this->bus_write_(BUS_CLASS_DFU, dfu_dnload_req, DFU_DNLOAD_FRAME_BYTES);
         if (error_code != i2c::ERROR_OK) {
           ESP_LOGE(TAG, "Final DFU download request failed");
           return UPDATE_COMMUNICATION_ERROR;
@@ -200,6 +1124,19 @@ RespeakerXVF3800UpdaterStatus RespeakerXVF3800::dfu_update_send_block_() {
           return UPDATE_FAILED;
         }
         ESP_LOGI(TAG, "Update complete");
+        this->save_dfu_fallback_(0);
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+        {
+          // Rate of this attempt, so the next estimate fits this array and bus
+          const uint32_t elapsed = millis() - this->update_start_time_;
+          if (elapsed > DFU_REBOOT_ESTIMATE_MS) {
+            this->dfu_rate_ = (uint64_t) this->firmware_bin_length_ * 1000 / (elapsed - DFU_REBOOT_ESTIMATE_MS);
+            this->dfu_rate_pref_.save(&this->dfu_rate_);
+            this->publish_dfu_schedule_();
+          }
+        }
+#endif
+        this->apply_audio_config_();
 #ifdef USE_RESPEAKER_XVF3800_STATE_CALLBACK
         this->state_callback_.call(DFU_COMPLETE, 100.0f, UPDATE_OK);
 #endif
@@ -213,25 +1150,140 @@ RespeakerXVF3800UpdaterStatus RespeakerXVF3800::dfu_update_send_block_() {
   return UPDATE_BAD_STATE;
 }
 
+void RespeakerXVF3800::dfu_recover_() {
+  if (this->dfu_attempts_ > this->dfu_max_retries_) {
+    ESP_LOGE(TAG, "Factory image fallback failed");
+    this->mark_failed();
+    return;
+  }
+
+  // Leave dfuERROR / dfuDNLOAD-IDLE so the next attempt starts from dfuIDLE; a device that is
+  // not in DFU mode at all just ignores these
+  this->dfu_command_(DFU_CONTROLLER_SERVICER_RESID_DFU_CLRSTATUS, "ClrStatus");
+  this->dfu_command_(DFU_CONTROLLER_SERVICER_RESID_DFU_ABORT, "Abort");
+  this->status_last_read_ms_ = 0;
+  this->dfu_status_next_req_delay_ = 0;
+
+  if (this->dfu_attempts_ < this->dfu_max_retries_) {
+    const uint32_t backoff = DFU_RETRY_BACKOFF_MS << this->dfu_attempts_;
+    this->dfu_attempts_++;
+    ESP_LOGW(TAG, "Update failed (status %u); retry %u of %u in %" PRIu32 "s", this->dfu_update_status_,
+             this->dfu_attempts_, this->dfu_max_retries_, backoff / 1000);
+    this->dfu_retry_at_ms_ = millis() + backoff;
+    this->dfu_update_status_ = UPDATE_RETRY_BACKOFF;
+    return;
+  }
+
+  // The factory partition is read-only over DFU; the boot loader falls back to it on its own once
+  // the upgrade partition no longer holds a valid image
+  ESP_LOGE(TAG, "Update failed %u times; falling back to the factory image", this->dfu_attempts_ + 1);
+  this->dfu_attempts_++;
+  if (!this->dfu_set_alternate_()) {
+    this->mark_failed();
+    return;
+  }
+  this->last_ready_ = millis();
+  this->dfu_update_status_ = UPDATE_FALLBACK_INVALIDATE;
+}
+
+RespeakerXVF3800UpdaterStatus RespeakerXVF3800::dfu_fallback_step_() {
+  uint8_t *frame = this->dfu_frame_;
+  if (this->dfu_update_status_ != UPDATE_FALLBACK_VERIFY && millis() > this->last_ready_ + DFU_TIMEOUT_MS) {
+    ESP_LOGE(TAG, "DFU timed out");
+    return UPDATE_TIMEOUT;
+  }
+
+  switch (this->dfu_update_status_) {
+    case UPDATE_FALLBACK_INVALIDATE:
+    case UPDATE_FALLBACK_MANIFEST:
+      if (!this->dfu_check_if_ready_()) {
+        return this->dfu_update_status_;
+      }
+      frame[0] = DFU_CONTROLLER_SERVICER_RESID;
+      frame[1] = DFU_CONTROLLER_SERVICER_RESID_DFU_DNLOAD;
+      frame[2] = DFU_DNLOAD_FRAME_BYTES - XMOS_HEADER_BYTES;
+      if (this->dfu_update_status_ == UPDATE_FALLBACK_INVALIDATE) {
+        // One block of erased flash: the download erases the slot and leaves no image header
+        frame[3] = MAX_XFER;
+        frame[4] = 0;
+        memset(&frame[XMOS_HEADER_BYTES + 2], 0xFF, MAX_XFER);
+      } else {
+        memset(&frame[XMOS_HEADER_BYTES], 0, DFU_DNLOAD_FRAME_BYTES - XMOS_HEADER_BYTES);
+      }
+      if (this->bus_write_(BUS_CLASS_DFU, frame, DFU_DNLOAD_FRAME_BYTES) != i2c::ERROR_OK) {
+        ESP_LOGE(TAG, "DFU download request failed");
+        return UPDATE_COMMUNICATION_ERROR;
+      }
+      return this->dfu_update_status_ == UPDATE_FALLBACK_INVALIDATE ? UPDATE_FALLBACK_MANIFEST
+                                                                    : UPDATE_FALLBACK_REBOOT;
+
+    case UPDATE_FALLBACK_REBOOT:
+      if (!this->dfu_check_if_ready_()) {
+        return UPDATE_FALLBACK_REBOOT;
+      }
+      ESP_LOGI(TAG, "Upgrade slot cleared -- rebooting XMOS SoC...");
+      if (!this->dfu_reboot_()) {
+        return UPDATE_COMMUNICATION_ERROR;
+      }
+      this->last_progress_ = millis();
+      this->last_ready_ = millis();
+      return UPDATE_FALLBACK_VERIFY;
+
+    case UPDATE_FALLBACK_VERIFY:
+      if (millis() - this->last_progress_ < 500) {
+        return UPDATE_FALLBACK_VERIFY;
+      }
+      this->last_progress_ = millis();
+      if (!this->dfu_get_version_()) {
+        return millis() - this->last_ready_ > DFU_FALLBACK_BOOT_MS ? UPDATE_TIMEOUT : UPDATE_FALLBACK_VERIFY;
+      }
+      if (this->versions_match_()) {
+        // The factory image already is the version being flashed; nothing is left to update
+        ESP_LOGI(TAG, "Factory image is %u.%u.%u; update complete", this->firmware_version_major_,
+                 this->firmware_version_minor_, this->firmware_version_patch_);
+        this->save_dfu_fallback_(0);
+        this->apply_audio_config_();
+        return UPDATE_OK;
+      }
+      if (this->firmware_version_major_ == this->dfu_prior_version_[0] &&
+          this->firmware_version_minor_ == this->dfu_prior_version_[1] &&
+          this->firmware_version_patch_ == this->dfu_prior_version_[2]) {
+        ESP_LOGW(TAG, "Back on %u.%u.%u; image %s (%u.%u.%u) is not used again", this->firmware_version_major_,
+                 this->firmware_version_minor_, this->firmware_version_patch_, this->firmware_bin_md5_,
+                 this->firmware_bin_version_major_, this->firmware_bin_version_minor_,
+                 this->firmware_bin_version_patch_);
+      } else {
+        // The upgrade slot held an earlier image; the factory image is older still
+        ESP_LOGW(TAG, "Running factory image %u.%u.%u (was %u.%u.%u); image %s (%u.%u.%u) is not used again",
+                 this->firmware_version_major_, this->firmware_version_minor_, this->firmware_version_patch_,
+                 this->dfu_prior_version_[0], this->dfu_prior_version_[1], this->dfu_prior_version_[2],
+                 this->firmware_bin_md5_, this->firmware_bin_version_major_, this->firmware_bin_version_minor_,
+                 this->firmware_bin_version_patch_);
+      }
+      this->dfu_fell_back_ = true;
+      this->save_dfu_fallback_(fnv1_hash(this->firmware_bin_md5_));
+      this->apply_audio_config_();
+      return UPDATE_OK;
+
+    default:
+      return UPDATE_BAD_STATE;
+  }
+}
+
 uint32_t RespeakerXVF3800::load_buf_(uint8_t *buf, const uint8_t max_len, const uint32_t offset) {
   if (offset > this->firmware_bin_length_) {
     ESP_LOGE(TAG, "Invalid offset");
     return 0;
   }
 
-  uint32_t buf_len = this->firmware_bin_length_ - offset;
-  if (buf_len > max_len) {
-    buf_len = max_len;
-  }
-
-  for (uint32_t i = 0; i < buf_len; i++) {
-    buf[i] = this->firmware_bin_[offset + i];
-  }
-  return buf_len;
+  return load_dfu_block(this->firmware_bin_, this->firmware_bin_length_, buf, max_len, offset);
 }
 
-bool RespeakerXVF3800::version_read_() {
-  return this->firmware_version_major_ || this->firmware_version_minor_ || this->firmware_version_patch_;
+void RespeakerXVF3800::save_dfu_fallback_(uint32_t image) {
+  if (this->dfu_fallback_image_ != image) {
+    this->dfu_fallback_image_ = image;
+    this->dfu_fallback_pref_.save(&this->dfu_fallback_image_);
+  }
 }
 
 bool RespeakerXVF3800::versions_match_() {
@@ -245,13 +1297,8 @@ bool RespeakerXVF3800::dfu_get_status_() {
                                 DFU_CONTROLLER_SERVICER_RESID_DFU_GETSTATUS | DFU_COMMAND_READ_BIT, 6};
   uint8_t status_resp[6];
 
-  auto error_code = this->write(status_req, sizeof(status_req));
-  if (error_code != i2c::ERROR_OK) {
-    ESP_LOGE(TAG, "Request status failed");
-    return false;
-  }
-
-  error_code = this->read(status_resp, sizeof(status_resp));
+  auto error_code =
+      this->bus_request_(BUS_CLASS_DFU, status_req, sizeof(status_req), status_resp, sizeof(status_resp));
   if (error_code != i2c::ERROR_OK || status_resp[0] != CTRL_DONE) {
     ESP_LOGE(TAG, "Read status failed");
     return false;
@@ -264,74 +1311,369 @@ bool RespeakerXVF3800::dfu_get_status_() {
   return true;
 }
 
-bool RespeakerXVF3800::dfu_get_version_() {
+bool RespeakerXVF3800::dfu_reboot_() {
+  const uint8_t reboot_req[] = {DFU_CONTROLLER_SERVICER_RESID, DFU_CONTROLLER_SERVICER_RESID_DFU_REBOOT, 1, 0};
+
+  auto error_code = this->bus_write_(BUS_CLASS_DFU, reboot_req, sizeof(reboot_req));
+  if (error_code != i2c::ERROR_OK) {
+    ESP_LOGE(TAG, "Reboot request failed");
+    return false;
+  }
+  return true;
+}
+
+bool RespeakerXVF3800::dfu_set_alternate_() {
+  const uint8_t setalternate_req[] = {DFU_CONTROLLER_SERVICER_RESID, DFU_CONTROLLER_SERVICER_RESID_DFU_SETALTERNATE, 1,
+                                      DFU_INT_ALTERNATE_UPGRADE};  // resid, cmd_id, payload length, payload data
+
+  auto error_code = this->bus_write_(BUS_CLASS_DFU, setalternate_req, sizeof(setalternate_req));
+  if (error_code != i2c::ERROR_OK) {
+    ESP_LOGE(TAG, "SetAlternate request failed");
+    return false;
+  }
+  return true;
+}
+
+bool RespeakerXVF3800::dfu_command_(uint8_t cmd, const char *name) {
+  const uint8_t request[] = {DFU_CONTROLLER_SERVICER_RESID, cmd, 1, 0};
+
+  auto error_code = this->bus_write_(BUS_CLASS_DFU, request, sizeof(request));
+  if (error_code != i2c::ERROR_OK) {
+    ESP_LOGW(TAG, "%s request failed", name);
+    return false;
+  }
+  return true;
+}
+
+bool RespeakerXVF3800::dfu_check_if_ready_() {
+  if (millis() >= this->status_last_read_ms_ + this->dfu_status_next_req_delay_) {
+    if (!this->dfu_get_status_()) {
+      return false;
+    }
+    ESP_LOGVV(TAG, "DFU state: %u, status: %u, delay: %" PRIu32, this->dfu_state_, this->dfu_status_,
+              this->dfu_status_next_req_delay_);
+
+    if ((this->dfu_state_ == DFU_INT_DFU_IDLE) || (this->dfu_state_ == DFU_INT_DFU_DNLOAD_IDLE) ||
+        (this->dfu_state_ == DFU_INT_DFU_MANIFEST_WAIT_RESET)) {
+      this->last_ready_ = millis();
+      return true;
+    }
+  }
+  return false;
+}
+#else
+void RespeakerXVF3800::start_dfu_update() { ESP_LOGE(TAG, "No firmware configured"); }
+
+void RespeakerXVF3800::request_dfu_update() { this->start_dfu_update(); }
+#endif
+
+bool RespeakerXVF3800::version_read_() {
+  return this->firmware_version_major_ || this->firmware_version_minor_ || this->firmware_version_patch_;
+}
+
+bool RespeakerXVF3800::read_version_(BusClass bus_class, uint8_t *version) {
   const uint8_t version_req[] = {DFU_CONTROLLER_SERVICER_RESID,
                                  DFU_CONTROLLER_SERVICER_RESID_DFU_GETVERSION | DFU_COMMAND_READ_BIT, 4};
   uint8_t version_resp[4];
 
-  auto error_code = this->write(version_req, sizeof(version_req));
-  if (error_code != i2c::ERROR_OK) {
-    ESP_LOGW(TAG, "Request version failed");
+  auto error_code =
+      this->bus_request_(bus_class, version_req, sizeof(version_req), version_resp, sizeof(version_resp));
+  if (error_code != i2c::ERROR_OK || version_resp[0] != CTRL_DONE) {
     return false;
   }
+  memcpy(version, &version_resp[1], 3);
+  return true;
+}
 
-  error_code = this->read(version_resp, sizeof(version_resp));
-  if (error_code != i2c::ERROR_OK || version_resp[0] != CTRL_DONE) {
+bool RespeakerXVF3800::dfu_get_version_() {
+  uint8_t version_resp[3];
+  if (!this->read_version_(BUS_CLASS_DFU, version_resp)) {
     ESP_LOGW(TAG, "Read version failed");
     return false;
   }
-
-  std::string version = str_sprintf("%u.%u.%u", version_resp[1], version_resp[2], version_resp[3]);
-  ESP_LOGI(TAG, "DFU version: %s", version.c_str());
-  this->firmware_version_major_ = version_resp[1];
-  this->firmware_version_minor_ = version_resp[2];
-  this->firmware_version_patch_ = version_resp[3];
-  if (this->firmware_version_ != nullptr) {
-    this->firmware_version_->publish_state(version);
+
+  std::string version = str_sprintf("%u.%u.%u", version_resp[0], version_resp[1], version_resp[2]);
+  ESP_LOGI(TAG, "DFU version: %s", version.c_str());
+  this->firmware_version_major_ = version_resp[0];
+  this->firmware_version_minor_ = version_resp[1];
+  this->firmware_version_patch_ = version_resp[2];
+  if (this->firmware_version_ != nullptr) {
+    this->firmware_version_->publish_state(version);
+  }
+
+  return true;
+}
+
+bool RespeakerXVF3800::write_output_config_() {
+  if (this->output_sample_rate_ == 0) {
+    return true;
+  }
+
+  const uint8_t upsample = this->output_sample_rate_ == 16000 ? 0 : 1;
+  const uint8_t upsample_lr[] = {upsample, upsample};
+  const uint8_t packed = this->output_word_format_ == OUTPUT_WORD_PACKED ? 1 : 0;
+  const uint8_t packed_lr[] = {packed, packed};
+
+  if (!this->xmos_write_bytes(AUDIO_MGR_SERVICER_RESID, AUDIO_MGR_OP_L_CMD, this->output_left_,
+                              sizeof(this->output_left_), BUS_CLASS_AUDIO) ||
+      !this->xmos_write_bytes(AUDIO_MGR_SERVICER_RESID, AUDIO_MGR_OP_R_CMD, this->output_right_,
+                              sizeof(this->output_right_), BUS_CLASS_AUDIO) ||
+      !this->xmos_write_bytes(AUDIO_MGR_SERVICER_RESID, AUDIO_MGR_OP_UPSAMPLE_CMD, upsample_lr, sizeof(upsample_lr),
+                              BUS_CLASS_AUDIO) ||
+      !this->xmos_write_bytes(AUDIO_MGR_SERVICER_RESID, AUDIO_MGR_OP_PACKED_CMD, packed_lr, sizeof(packed_lr),
+                              BUS_CLASS_AUDIO)) {
+    return false;
+  }
+
+  ESP_LOGI(TAG, "Audio output set to %" PRIu32 " Hz%s", this->output_sample_rate_,
+           this->output_word_format_ == OUTPUT_WORD_PACKED ? " (packed)" : "");
+  return true;
+}
+
+bool RespeakerXVF3800::write_aec_delay_(int32_t delay) {
+  uint8_t payload[sizeof(int32_t)];
+  memcpy(payload, &delay, sizeof(payload));  // int32, little-endian on XS3
+  return this->xmos_write_bytes(AUDIO_MGR_SERVICER_RESID, AUDIO_MGR_SYS_DELAY_CMD, payload, sizeof(payload),
+                                BUS_CLASS_AUDIO);
+}
+
+void RespeakerXVF3800::apply_audio_config_() {
+#ifdef USE_RESPEAKER_XVF3800_ACOUSTIC_PROFILES
+  this->invalidate_acoustic_shadow_();
+#endif
+  if (!this->write_output_config_()) {
+    ESP_LOGW(TAG, "Writing audio output configuration failed");
+  }
+#ifdef USE_RESPEAKER_XVF3800_AEC_CALIBRATION
+  if (this->aec_delay_valid_) {
+    if (this->write_aec_delay_(this->aec_delay_)) {
+      ESP_LOGI(TAG, "Restored AEC reference delay: %" PRId32 " samples", this->aec_delay_);
+    } else {
+      ESP_LOGW(TAG, "Writing AEC reference delay failed");
+    }
+  }
+#endif
+}
+
+#ifdef USE_RESPEAKER_XVF3800_ACOUSTIC_PROFILES
+bool RespeakerXVF3800::apply_acoustic_profile(const std::string &name) {
+  const AcousticProfile *profile = nullptr;
+  for (const auto &candidate : this->acoustic_profiles_) {
+    if (name == candidate.name) {
+      profile = &candidate;
+      break;
+    }
+  }
+  if (profile == nullptr) {
+    ESP_LOGW(TAG, "Unknown acoustic profile '%s'", name.c_str());
+    return false;
+  }
+  if (this->dfu_busy_()) {
+    ESP_LOGW(TAG, "Not applying acoustic profile during a firmware update");
+    return false;
+  }
+
+  uint8_t written = 0;
+  uint8_t skipped = 0;
+  bool ok = true;
+  const uint32_t start = micros();
+  for (uint16_t pos = 0, index = 0; pos < profile->frames_len; index++) {
+    const uint8_t *frame = &profile->frames[pos];
+    const uint8_t payload_len = frame[2];
+    pos += XMOS_HEADER_BYTES + payload_len;
+
+    uint8_t *shadow = &this->acoustic_shadow_[profile->shadow_offsets[index]];
+    if (shadow[0] && memcmp(&shadow[1], &frame[XMOS_HEADER_BYTES], payload_len) == 0) {
+      skipped++;
+      continue;
+    }
+    // The compiled record already is the wire frame
+    if (this->bus_write_(BUS_CLASS_CONTROL, frame, XMOS_HEADER_BYTES + payload_len) != i2c::ERROR_OK) {
+      ESP_LOGW(TAG, "Writing resid=%u, cmd=%u failed", frame[0], frame[1]);
+      shadow[0] = 0;
+      ok = false;
+      break;
+    }
+    shadow[0] = 1;
+    memcpy(&shadow[1], &frame[XMOS_HEADER_BYTES], payload_len);
+    written++;
+  }
+  const uint32_t latency = micros() - start;
+
+  if (ok) {
+    this->active_acoustic_profile_ = profile->name;
+  }
+  ESP_LOGI(TAG, "Acoustic profile '%s' %s: %u written, %u unchanged, %" PRIu32 " us", profile->name,
+           ok ? "applied" : "failed", written, skipped, latency);
+  if (this->profile_latency_sensor_ != nullptr) {
+    this->profile_latency_sensor_->publish_state(latency);
+  }
+  return ok;
+}
+
+void RespeakerXVF3800::invalidate_acoustic_shadow_() {
+  std::fill(this->acoustic_shadow_.begin(), this->acoustic_shadow_.end(), 0);
+}
+#else
+bool RespeakerXVF3800::apply_acoustic_profile(const std::string &name) {
+  ESP_LOGE(TAG, "No acoustic profiles configured");
+  return false;
+}
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_AEC_CALIBRATION
+void RespeakerXVF3800::start_aec_calibration() {
+  if (this->calibration_active_) {
+    ESP_LOGW(TAG, "AEC calibration already running");
+    return;
+  }
+  if (this->dfu_busy_() || this->calibration_speaker_ == nullptr) {
+    ESP_LOGW(TAG, "AEC calibration not possible right now");
+    return;
+  }
+  // Remember the firmware's delay so a failed run can put it back
+  if (!this->aec_delay_valid_ &&
+      !this->xmos_read_bytes(AUDIO_MGR_SERVICER_RESID, AUDIO_MGR_SYS_DELAY_CMD, (uint8_t *) &this->aec_delay_,
+                             sizeof(this->aec_delay_), BUS_CLASS_AUDIO)) {
+    ESP_LOGW(TAG, "Reading current AEC reference delay failed");
+    return;
   }
 
-  return true;
+  ESP_LOGI(TAG, "Starting AEC delay calibration: %" PRId32 "..%" PRId32 " samples, step %" PRId32,
+           this->calibration_min_delay_, this->calibration_max_delay_, this->calibration_step_);
+  this->calibration_callback_.call(true);
+  this->calibration_speaker_->set_audio_stream_info(audio::AudioStreamInfo(16, 1, 16000));
+  this->calibration_speaker_->start();
+
+  this->calibration_best_converged_ = -1;
+  this->calibration_candidate_ = this->calibration_min_delay_ - this->calibration_step_;
+  this->calibration_samples_ = 0;  // makes the first loop pass move to the first candidate
+  this->calibration_candidate_start_ms_ = millis() - this->calibration_dwell_ms_;
+  this->calibration_generation_++;  // drops samples still queued from an earlier run
+  this->calibration_active_ = true;
 }
 
-bool RespeakerXVF3800::dfu_reboot_() {
-  const uint8_t reboot_req[] = {DFU_CONTROLLER_SERVICER_RESID, DFU_CONTROLLER_SERVICER_RESID_DFU_REBOOT, 1, 0};
+bool RespeakerXVF3800::is_calibrating() const { return this->calibration_active_; }
+
+void RespeakerXVF3800::aec_calibration_loop_() {
+  this->feed_calibration_probe_();
+
+  const uint32_t now = millis();
+  const uint32_t elapsed = now - this->calibration_candidate_start_ms_;
+
+  if (elapsed >= this->calibration_dwell_ms_) {
+    if (this->calibration_samples_ > 0) {
+      const float converged = (float) this->calibration_converged_samples_ / this->calibration_samples_;
+      const float energy = this->calibration_energy_sum_ / this->calibration_samples_;
+      ESP_LOGD(TAG, "AEC delay %" PRId32 ": converged %.0f%%, residual energy %g", this->calibration_candidate_,
+               converged * 100.0f, energy);
+      // Convergence ratio decides; residual energy only breaks (near) ties
+      if (converged > this->calibration_best_converged_ + 0.05f ||
+          (converged >= this->calibration_best_converged_ - 0.05f && energy < this->calibration_best_energy_)) {
+        this->calibration_best_delay_ = this->calibration_candidate_;
+        this->calibration_best_converged_ = converged;
+        this->calibration_best_energy_ = energy;
+      }
+    }
 
-  auto error_code = this->write(reboot_req, sizeof(reboot_req));
-  if (error_code != i2c::ERROR_OK) {
-    ESP_LOGE(TAG, "Reboot request failed");
-    return false;
+    this->calibration_candidate_ += this->calibration_step_;
+    if (this->calibration_candidate_ > this->calibration_max_delay_) {
+      this->finish_aec_calibration_();
+      return;
+    }
+    if (!this->write_aec_delay_(this->calibration_candidate_)) {
+      ESP_LOGE(TAG, "AEC calibration aborted");
+      this->calibration_best_converged_ = -1;
+      this->finish_aec_calibration_();
+      return;
+    }
+    this->calibration_candidate_start_ms_ = now;
+    this->calibration_generation_++;
+    this->calibration_samples_ = 0;
+    this->calibration_converged_samples_ = 0;
+    this->calibration_energy_sum_ = 0;
+    return;
   }
-  return true;
+
+  // Give the canceller the first half of the dwell time to adapt, then sample every 100ms
+  if (elapsed < this->calibration_dwell_ms_ / 2 || now - this->calibration_last_sample_ms_ < 100 ||
+      this->calibration_reads_.is_running()) {
+    return;
+  }
+  this->calibration_last_sample_ms_ = now;
+
+  this->calibration_sample_generation_ = this->calibration_generation_;
+  this->calibration_sample_ok_ = true;
+  this->calibration_reads_.begin(2);
+  this->calibration_reads_.read(this, BUS_CLASS_AUDIO, 0, AEC_SERVICER_RESID, AEC_AECCONVERGED_CMD, sizeof(int32_t));
+  this->calibration_reads_.read(this, BUS_CLASS_AUDIO, 1, AEC_SERVICER_RESID, AEC_SPENERGY_VALUES_CMD,
+                                4 * sizeof(float));
 }
 
-bool RespeakerXVF3800::dfu_set_alternate_() {
-  const uint8_t setalternate_req[] = {DFU_CONTROLLER_SERVICER_RESID, DFU_CONTROLLER_SERVICER_RESID_DFU_SETALTERNATE, 1,
-                                      DFU_INT_ALTERNATE_UPGRADE};  // resid, cmd_id, payload length, payload data
+void RespeakerXVF3800::calibration_read_(uint8_t read, bool ok, const uint8_t *data) {
+  this->calibration_sample_ok_ &= ok;
+  if (!ok) {
+    return;
+  }
+  if (read == 0) {
+    int32_t converged;
+    memcpy(&converged, data, sizeof(converged));
+    this->calibration_sample_converged_ = converged != 0;
+  } else {
+    memcpy(&this->calibration_sample_energy_, &data[3 * sizeof(float)], sizeof(float));  // auto-select beam
+  }
+}
 
-  auto error_code = this->write(setalternate_req, sizeof(setalternate_req));
-  if (error_code != i2c::ERROR_OK) {
-    ESP_LOGE(TAG, "SetAlternate request failed");
-    return false;
+// Records a complete sample, unless the candidate moved on or the run ended while it was queued
+void RespeakerXVF3800::record_calibration_sample_() {
+  if (!this->calibration_sample_ok_ || !this->calibration_active_ ||
+      this->calibration_sample_generation_ != this->calibration_generation_) {
+    return;
   }
-  return true;
+  this->calibration_samples_++;
+  if (this->calibration_sample_converged_) {
+    this->calibration_converged_samples_++;
+  }
+  this->calibration_energy_sum_ += this->calibration_sample_energy_;
 }
 
-bool RespeakerXVF3800::dfu_check_if_ready_() {
-  if (millis() >= this->status_last_read_ms_ + this->dfu_status_next_req_delay_) {
-    if (!this->dfu_get_status_()) {
-      return false;
+void RespeakerXVF3800::feed_calibration_probe_() {
+  if (this->probe_offset_ >= sizeof(this->probe_buffer_)) {
+    // White noise at roughly -12 dBFS
+    for (int16_t &sample : this->probe_buffer_) {
+      this->probe_seed_ = this->probe_seed_ * 1664525 + 1013904223;
+      sample = (int16_t) ((int32_t) (this->probe_seed_ >> 16) - 32768) / 4;
     }
-    ESP_LOGVV(TAG, "DFU state: %u, status: %u, delay: %" PRIu32, this->dfu_state_, this->dfu_status_,
-              this->dfu_status_next_req_delay_);
+    this->probe_offset_ = 0;
+  }
+  this->probe_offset_ += this->calibration_speaker_->play((const uint8_t *) this->probe_buffer_ + this->probe_offset_,
+                                                          sizeof(this->probe_buffer_) - this->probe_offset_);
+}
 
-    if ((this->dfu_state_ == DFU_INT_DFU_IDLE) || (this->dfu_state_ == DFU_INT_DFU_DNLOAD_IDLE) ||
-        (this->dfu_state_ == DFU_INT_DFU_MANIFEST_WAIT_RESET)) {
-      this->last_ready_ = millis();
-      return true;
-    }
+void RespeakerXVF3800::finish_aec_calibration_() {
+  this->calibration_speaker_->stop();
+  this->calibration_active_ = false;
+  this->calibration_callback_.call(false);
+
+  if (this->calibration_best_converged_ < 0) {
+    // Nothing usable measured: fall back to the previous delay
+    ESP_LOGW(TAG, "AEC calibration produced no result; keeping delay %" PRId32, this->aec_delay_);
+    this->write_aec_delay_(this->aec_delay_);
+    return;
   }
-  return false;
+
+  this->aec_delay_ = this->calibration_best_delay_;
+  this->aec_delay_valid_ = true;
+  this->write_aec_delay_(this->aec_delay_);
+  this->aec_delay_pref_.save(&this->aec_delay_);
+  ESP_LOGI(TAG, "AEC calibration done: delay %" PRId32 " samples (converged %.0f%%)", this->aec_delay_,
+           this->calibration_best_converged_ * 100.0f);
 }
+#else
+void RespeakerXVF3800::start_aec_calibration() { ESP_LOGE(TAG, "AEC calibration is not configured"); }
+
+bool RespeakerXVF3800::is_calibrating() const { return false; }
+#endif
 
 bool RespeakerXVF3800::read_gpo_values(uint8_t *buffer, uint8_t *status) {
   const uint8_t request[] = {GPO_SERVICER_RESID, 
@@ -339,7 +1681,7 @@ bool RespeakerXVF3800::read_gpo_values(uint8_t *buffer, uint8_t *status) {
                             GPO_GPO_READ_NUM_BYTES + 1};
 
   uint8_t data[6] = {0};
-  i2c::ErrorCode err = this->write_read(request, sizeof(request), data, sizeof(data));
+  i2c::ErrorCode err = this->bus_write_read_(BUS_CLASS_TELEMETRY, request, sizeof(request), data, sizeof(data));
   
   if (err != i2c::ERROR_OK) {
     ESP_LOGW(TAG, "Failed to read GPO statuses, error=%d", (int)err);
@@ -359,263 +1701,569 @@ bool RespeakerXVF3800::read_mute_status() {
   uint8_t status = 0xFF;
   
   if (this->read_gpo_values(gpo_values, &status)) {
-    ESP_LOGD(TAG, "GPO Status: %02X, GPO data: %02X %02X %02X %02X %02X", 
+    ESP_LOGV(TAG, "GPO Status: %02X, GPO data: %02X %02X %02X %02X %02X", 
              status, gpo_values[0], gpo_values[1], gpo_values[2], gpo_values[3], gpo_values[4]);
     
     bool gpio30 = (gpo_values[1] & 0x01) != 0;
-    ESP_LOGD(TAG, "GPIO30 (mute): %s", gpio30 ? "MUTED" : "UNMUTED");
+    ESP_LOGV(TAG, "GPIO30 (mute): %s", gpio30 ? "MUTED" : "UNMUTED");
+    XVF3800_TRACE(this, TRACE_MUTE, GPO_SERVICER_RESID, GPO_SERVICER_RESID_GPO_READ_VALUES, status, 0, gpio30);
     return gpio30;
   }
   return false;
 }
 
 void RespeakerXVF3800::write_mute_status(bool value) {
-  uint8_t payload[] = {GPO_SERVICER_RESID, GPO_SERVICER_RESID_GPO_WRITE_VALUE, 2, 30, (uint8_t)(value ? 1 : 0)};
-  
-  ESP_LOGD(TAG, "Writing mute status %s to GPIO 30: [0x%02X, 0x%02X, 0x%02X, %d, %d]", 
-           value ? "MUTE" : "UNMUTE", payload[0], payload[1], payload[2], payload[3], payload[4]);
-  
-  i2c::ErrorCode err = this->write(payload, sizeof(payload));
+  const uint8_t payload[] = {30, (uint8_t)(value ? 1 : 0)};  // GPIO 30, level
 
-  if (err != i2c::ERROR_OK) {
-    ESP_LOGW(TAG, "Error writing mute status to GPIO 30. Error code: %d", (int)err);
-  }
+  ESP_LOGD(TAG, "Writing mute status %s to GPIO 30", value ? "MUTE" : "UNMUTE");
+
+  this->xmos_write_async(BUS_CLASS_CONTROL, GPO_SERVICER_RESID, GPO_SERVICER_RESID_GPO_WRITE_VALUE, payload,
+                         sizeof(payload), [](bool ok, const uint8_t *) {
+                           if (!ok) {
+                             ESP_LOGW(TAG, "Error writing mute status to GPIO 30");
+                           }
+                         });
 }
 
-bool RespeakerXVF3800::read_azimuth_radians_(float &out_radians, uint8_t beam_index) {
+bool RespeakerXVF3800::read_azimuth_radians_(float &out_radians, uint8_t beam_index, BusClass bus_class) {
   if (beam_index > 3) {
     ESP_LOGW(TAG, "read_azimuth_radians_: invalid beam index %u", beam_index);
     return false;
   }
 
-  const uint8_t aec_req[] = {AEC_SERVICER_RESID,
-                             AEC_AZIMUTH_VALUES_CMD | 0x80,
-                             17};  // 16 bytes (4 floats) + 1 status byte
-
-  uint8_t aec_resp[17];
-
-  // The XMOS transport protocol can return CTRL_WAIT (1) when the servicer is
-  // busy; the host is expected to retry. The fast LED poll hides this naturally,
-  // but a one-shot read (e.g. from lock_beam) has to retry explicitly.
-  const uint8_t max_attempts = 8;
-  for (uint8_t attempt = 0; attempt < max_attempts; attempt++) {
-    i2c::ErrorCode err = this->write_read(aec_req, sizeof(aec_req), aec_resp, sizeof(aec_resp));
-    if (err != i2c::ERROR_OK) {
-      ESP_LOGW(TAG, "Failed to read AEC azimuth values, error=%d", (int)err);
-      return false;
-    }
-
-    uint8_t status = aec_resp[0];
-    if (status == CTRL_DONE) {
-      // 4 floats follow at bytes [1..16]: beam 1, beam 2, free-running, auto-select.
-      const uint8_t offset = 1 + beam_index * sizeof(float);
-      float radians;
-      memcpy(&radians, &aec_resp[offset], sizeof(float));
-      ESP_LOGD(TAG, "AEC azimuth (beam %u, raw radians): %f", beam_index, radians);
-      out_radians = radians;
-      return true;
-    }
-
-    if (status != CTRL_WAIT && status != SERVICER_COMMAND_RETRY) {
-      ESP_LOGW(TAG, "AEC azimuth read returned unexpected status 0x%02X — giving up", status);
-      return false;
-    }
-
-    delayMicroseconds(500);
+  // 4 floats: beam 1, beam 2, free-running, auto-select.
+  float azimuths[4];
+  if (!this->xmos_read_bytes(AEC_SERVICER_RESID, AEC_AZIMUTH_VALUES_CMD, (uint8_t *) azimuths, sizeof(azimuths),
+                             bus_class)) {
+    return false;
   }
-
-  // Exhausted retries on a retry status. This is normal during silence
-  // (no source to localize → no fresh azimuth), hence DEBUG not WARN.
-  ESP_LOGD(TAG, "AEC azimuth read still busy after %u attempts (no fresh data)", max_attempts);
-  return false;
+  ESP_LOGV(TAG, "AEC azimuth (beam %u, raw radians): %f", beam_index, azimuths[beam_index]);
+  XVF3800_TRACE(this, TRACE_AZIMUTH, AEC_SERVICER_RESID, AEC_AZIMUTH_VALUES_CMD, beam_index, 0, azimuths[beam_index]);
+  out_radians = azimuths[beam_index];
+  return true;
 }
 
 int RespeakerXVF3800::read_led_beam_direction() {
   float radians;
   // When locked, read beam 1 (the pinned fixed beam) straight from the chip;
   // otherwise read the auto-select beam (the adaptive default).
-  const uint8_t beam_index = this->beam_locked_ ? 0 : 3;
-  if (!this->read_azimuth_radians_(radians, beam_index)) {
+  const uint8_t beam_index = tracked_beam_slot(this->is_beam_locked());
+  if (!this->read_azimuth_radians_(radians, beam_index, BUS_CLASS_TELEMETRY)) {
     return -1;
   }
 
-  float degrees = radians * 180.0f / M_PI;
-
-  // Map degrees to LED index (0-11). Each LED covers 30 degrees.
-  int led_index = (int)roundf(degrees / 30.0f);
-  if (led_index < 0) {
-    led_index += 12;
-  }
-  led_index = led_index % 12;
-
-  ESP_LOGD(TAG, "AEC azimuth: %.1f degrees -> LED %d", degrees, led_index);
+  int led_index = azimuth_to_led_index(radians);
+  ESP_LOGV(TAG, "AEC azimuth: %.1f degrees -> LED %d", radians * 180.0f / M_PI, led_index);
+  XVF3800_TRACE(this, TRACE_LED_BEAM, AEC_SERVICER_RESID, AEC_AZIMUTH_VALUES_CMD, beam_index, 0, led_index);
 
   return led_index;
 }
 
+int RespeakerXVF3800::azimuth_to_led_index(float radians) { return led_index_for_azimuth(radians); }
+
+#ifdef USE_RESPEAKER_XVF3800_BEAM_LOCK
 void RespeakerXVF3800::lock_beam() {
-  float radians;
-  if (!this->read_azimuth_radians_(radians)) {
-    ESP_LOGW(TAG, "lock_beam: failed to read current azimuth; not locking");
-    return;
-  }
+  // Auto-select beam azimuth (slot 3 of cmd 75); the lock takes effect once the read completes
+  this->xmos_read_async(BUS_CLASS_CONTROL, AEC_SERVICER_RESID, AEC_AZIMUTH_VALUES_CMD, 4 * sizeof(float),
+                        [this](bool ok, const uint8_t *azimuths) {
+                          if (!ok) {
+                            ESP_LOGW(TAG, "lock_beam: failed to read current azimuth; not locking");
+                            return;
+                          }
+                          float radians;
+                          memcpy(&radians, &azimuths[3 * sizeof(float)], sizeof(float));
+                          this->write_beam_lock_(radians);
+                        });
+}
 
+void RespeakerXVF3800::write_beam_lock_(float radians) {
   // AEC_FIXEDBEAMSAZIMUTH_VALUES is 2 floats (radians): fixed beam 1, fixed beam 2.
   // We point both at the same direction so whichever beam is gated picks up the source.
   uint8_t payload[2 * sizeof(float)];
   memcpy(&payload[0], &radians, sizeof(float));
   memcpy(&payload[sizeof(float)], &radians, sizeof(float));
-  this->xmos_write_bytes(AEC_SERVICER_RESID, AEC_FIXEDBEAMS_AZIMUTH_CMD, payload, sizeof(payload));
+  this->xmos_write_async(BUS_CLASS_CONTROL, AEC_SERVICER_RESID, AEC_FIXEDBEAMS_AZIMUTH_CMD, payload, sizeof(payload));
 
   // AEC_FIXEDBEAMSONOFF is int32 (little-endian on XS3).
   uint8_t on[4] = {0x01, 0x00, 0x00, 0x00};
-  this->xmos_write_bytes(AEC_SERVICER_RESID, AEC_FIXEDBEAMS_ONOFF_CMD, on, sizeof(on));
+  this->xmos_write_async(BUS_CLASS_CONTROL, AEC_SERVICER_RESID, AEC_FIXEDBEAMS_ONOFF_CMD, on, sizeof(on));
 
   this->beam_locked_ = true;
+  this->locked_azimuth_ = radians;
 
   ESP_LOGI(TAG, "Beam locked at %.3f rad (%.1f deg)", radians, radians * 180.0f / (float)M_PI);
 }
 
 void RespeakerXVF3800::unlock_beam() {
   uint8_t off[4] = {0x00, 0x00, 0x00, 0x00};
-  this->xmos_write_bytes(AEC_SERVICER_RESID, AEC_FIXEDBEAMS_ONOFF_CMD, off, sizeof(off));
+  this->xmos_write_async(BUS_CLASS_CONTROL, AEC_SERVICER_RESID, AEC_FIXEDBEAMS_ONOFF_CMD, off, sizeof(off));
   this->beam_locked_ = false;
   ESP_LOGI(TAG, "Beam lock released");
 }
+#endif
 
-void RespeakerXVF3800::xmos_write_bytes(uint8_t resid, uint8_t cmd, const uint8_t *value, uint8_t write_byte_num) {
-  uint8_t payload[3 + 255];
-  payload[0] = resid;
-  payload[1] = cmd;
-  payload[2] = write_byte_num;
+bool RespeakerXVF3800::xmos_write_bytes(uint8_t resid, uint8_t cmd, const uint8_t *value, uint8_t write_byte_num,
+                                        BusClass bus_class) {
+  if (write_byte_num > XMOS_MAX_WRITE_BYTES) {
+    ESP_LOGW(TAG, "xmos_write_bytes: %u bytes requested, max is %u", write_byte_num, XMOS_MAX_WRITE_BYTES);
+    return false;
+  }
 
+  uint8_t frame[XMOS_HEADER_BYTES + XMOS_MAX_WRITE_BYTES];
   if (write_byte_num > 0 && value != nullptr) {
-    memcpy(&payload[3], value, write_byte_num);
+    memcpy(&frame[XMOS_HEADER_BYTES], value, write_byte_num);
   }
+  return this->xmos_write_frame_(resid, cmd, frame, write_byte_num, bus_class);
+}
 
-  i2c::ErrorCode err = this->write(payload, 3 + write_byte_num);
-  
+bool RespeakerXVF3800::xmos_write_frame_(uint8_t resid, uint8_t cmd, uint8_t *frame, uint8_t payload_len,
+                                         BusClass bus_class) {
+  frame[0] = resid;
+  frame[1] = cmd;
+  frame[2] = payload_len;
+
+#ifdef USE_RESPEAKER_XVF3800_TRACE
+  const uint32_t start = micros();
+#endif
+  i2c::ErrorCode err = this->bus_write_(bus_class, frame, XMOS_HEADER_BYTES + payload_len);
+  XVF3800_TRACE(this, TRACE_XMOS_WRITE, resid, cmd, err, micros() - start, payload_len);
   if (err != i2c::ERROR_OK) {
     ESP_LOGW(TAG, "Error in xmos_write_bytes. resid=%d, cmd=%d, error=%d", resid, cmd, (int)err);
+    return false;
+  }
+  return true;
+}
+
+bool RespeakerXVF3800::xmos_read_bytes(uint8_t resid, uint8_t cmd, uint8_t *value, uint8_t read_byte_num,
+                                       BusClass bus_class, uint8_t *last_status) {
+  if (read_byte_num > XMOS_MAX_READ_BYTES) {
+    ESP_LOGW(TAG, "xmos_read_bytes: %u bytes requested, max is %u", read_byte_num, XMOS_MAX_READ_BYTES);
+    return false;
+  }
+
+  const uint8_t request[] = {resid, (uint8_t) (cmd | I2C_COMMAND_READ_BIT), (uint8_t) (read_byte_num + 1)};
+  uint8_t response[XMOS_MAX_READ_BYTES + 1];  // status byte + payload
+
+  // The XMOS transport protocol can return CTRL_WAIT (1) when the servicer is
+  // busy; the host is expected to retry. The fast LED poll hides this naturally,
+  // but a one-shot read (e.g. from lock_beam) has to retry explicitly.
+  const uint8_t max_attempts = 8;
+#ifdef USE_RESPEAKER_XVF3800_TRACE
+  const uint32_t start = micros();
+#endif
+  for (uint8_t attempt = 0; attempt < max_attempts; attempt++) {
+    i2c::ErrorCode err = this->bus_write_read_(bus_class, request, sizeof(request), response, read_byte_num + 1);
+    if (err != i2c::ERROR_OK) {
+      if (last_status != nullptr) {
+        *last_status = XMOS_STATUS_I2C_ERROR;
+      }
+      XVF3800_TRACE(this, TRACE_XMOS_READ, resid, cmd, XMOS_STATUS_I2C_ERROR, micros() - start, attempt + 1);
+      ESP_LOGW(TAG, "Failed to read resid=%u, cmd=%u, error=%d", resid, cmd, (int) err);
+      return false;
+    }
+
+    uint8_t status = response[0];
+    if (last_status != nullptr) {
+      *last_status = status;
+    }
+    if (status == CTRL_DONE || (status != CTRL_WAIT && status != SERVICER_COMMAND_RETRY) ||
+        attempt + 1 == max_attempts) {
+      XVF3800_TRACE(this, TRACE_XMOS_READ, resid, cmd, status, micros() - start, attempt + 1);
+    }
+    if (status == CTRL_DONE) {
+      memcpy(value, &response[1], read_byte_num);
+      return true;
+    }
+
+    if (status != CTRL_WAIT && status != SERVICER_COMMAND_RETRY) {
+      ESP_LOGW(TAG, "Read resid=%u, cmd=%u returned unexpected status 0x%02X — giving up", resid, cmd, status);
+      return false;
+    }
+
+    delayMicroseconds(500);
+  }
+
+  // Exhausted retries on a retry status. This is normal during silence for the
+  // AEC azimuth read (no source to localize → no fresh azimuth), hence VERBOSE not WARN.
+  ESP_LOGV(TAG, "Read resid=%u, cmd=%u still busy after %u attempts (no fresh data)", resid, cmd, max_attempts);
+  return false;
+}
+
+bool RespeakerXVF3800::xmos_write_async(BusClass bus_class, uint8_t resid, uint8_t cmd, const uint8_t *value,
+                                        uint8_t write_byte_num, XmosCompletion &&callback) {
+  if (!this->is_healthy()) {
+    return false;  // recovery restores the hub's state afterwards
+  }
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+  if (this->control_task_.is_running()) {
+    if (!this->control_task_.submit_write(bus_class, resid, cmd, value, write_byte_num, std::move(callback))) {
+      return false;
+    }
+    this->bus_scheduler_.queued(bus_class);
+    return true;
+  }
+#endif
+  bool ok = this->xmos_write_bytes(resid, cmd, value, write_byte_num, bus_class);
+  if (callback) {
+    callback(ok, nullptr);
+  }
+  return true;
+}
+
+bool RespeakerXVF3800::xmos_read_async(BusClass bus_class, uint8_t resid, uint8_t cmd, uint8_t read_byte_num,
+                                       XmosCompletion &&callback) {
+  if (!this->is_healthy()) {
+    return false;
+  }
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+  if (this->control_task_.is_running()) {
+    if (!this->control_task_.submit_read(bus_class, resid, cmd, read_byte_num, std::move(callback))) {
+      return false;
+    }
+    this->bus_scheduler_.queued(bus_class);
+    return true;
+  }
+#endif
+  uint8_t value[XMOS_MAX_READ_BYTES];
+  uint8_t status = XMOS_STATUS_I2C_ERROR;
+  bool ok = this->xmos_read_bytes(resid, cmd, value, read_byte_num, bus_class, &status);
+  if (!ok) {
+    value[0] = status;
+  }
+  if (callback) {
+    callback(ok, value);
+  }
+  return true;
+}
+
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+void RespeakerXVF3800::execute_control_command_(ControlCommand &command) {
+  this->bus_scheduler_.dequeued(command.bus_class);
+  if (command.read) {
+    uint8_t status = XMOS_STATUS_I2C_ERROR;
+    command.ok =
+        this->xmos_read_bytes(command.resid, command.cmd, command.payload(), command.len, command.bus_class, &status);
+    if (!command.ok) {
+      command.payload()[0] = status;
+    }
+  } else {
+    command.ok = this->xmos_write_frame_(command.resid, command.cmd, command.frame, command.len, command.bus_class);
   }
 }
+#endif
 
+#ifdef USE_RESPEAKER_XVF3800_LED_RING
 void RespeakerXVF3800::set_led_ring(uint32_t *rgb_array) {
-  ESP_LOGD(TAG, "Setting LED ring with individual colors");
+  ESP_LOGV(TAG, "Setting LED ring with individual colors");
   
-  uint8_t payload[48];
+  [[maybe_unused]] const uint8_t lit = pack_led_frame(rgb_array, this->led_pixels_());
+  this->led_frame_valid_ = true;
+  XVF3800_TRACE(this, TRACE_LED_FRAME, GPO_SERVICER_RESID, GPO_SERVICER_RESID_LED_RING_VALUE, 0, 0, lit);
   
-  for (int i = 0; i < 12; i++) {
-    uint32_t color = rgb_array[i];
-    payload[i * 4 + 0] = (uint8_t)(color & 0xFF);
-    payload[i * 4 + 1] = (uint8_t)((color >> 8) & 0xFF);
-    payload[i * 4 + 2] = (uint8_t)((color >> 16) & 0xFF);
-    payload[i * 4 + 3] = 0x00;
+  // Over budget or recovering: keep only the newest frame and let loop() send it later
+  this->led_frame_pending_ = true;
+  if (this->is_healthy()) {
+    this->flush_led_frame_();
   }
-  
-  this->xmos_write_bytes(GPO_SERVICER_RESID, GPO_SERVICER_RESID_LED_RING_VALUE, payload, 48);
 }
+#endif
 
-std::string RespeakerXVF3800::read_dfu_version() {
-  uint8_t data[4] = {0};
-  
-  const uint8_t request[] = {0xF0, 0x58 | I2C_COMMAND_READ_BIT, 4};
-  
-  i2c::ErrorCode err = this->write(request, sizeof(request));
-  if (err == i2c::ERROR_OK) {
-    err = this->read(data, 4);
-    if (err == i2c::ERROR_OK && data[0] == 0) {
-      ESP_LOGI(TAG, "Version request successful: %u.%u.%u", data[1], data[2], data[3]);
-      return str_sprintf("%u.%u.%u", data[1], data[2], data[3]);
+#ifdef USE_RESPEAKER_XVF3800_LED_ANIMATIONS
+bool RespeakerXVF3800::play_led_animation(const std::string &name, float brightness) {
+  brightness = std::max(0.0f, std::min(brightness, 1.0f));
+  // Start at the current time so the first frame goes out on the next loop()
+  const uint32_t now = millis();
+  if (!this->led_animations_.start(name.c_str(), now, (uint8_t) roundf(brightness * 255.0f))) {
+    ESP_LOGW(TAG, "Unknown LED animation '%s'", name.c_str());
+    return false;
+  }
+  this->led_animation_last_ms_ = now - this->led_animation_interval_;
+  ESP_LOGD(TAG, "Playing LED animation '%s'", name.c_str());
+  return true;
+}
+
+void RespeakerXVF3800::stop_led_animation() { this->led_animations_.stop(); }
+#else
+bool RespeakerXVF3800::play_led_animation(const std::string &name, float brightness) {
+  ESP_LOGE(TAG, "No LED animations configured");
+  return false;
+}
+
+void RespeakerXVF3800::stop_led_animation() {}
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_LED_RING
+void RespeakerXVF3800::flush_led_frame_() {
+  if (!this->bus_scheduler_.admit(BUS_CLASS_LED, write_bus_bytes(LED_RING_PAYLOAD_BYTES))) {
+    return;
+  }
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+  if (this->control_task_.is_running()) {
+    // The pixels are copied into the queue, so led_frame_ is free again right away
+    if (!this->control_task_.submit_write(BUS_CLASS_LED, GPO_SERVICER_RESID, GPO_SERVICER_RESID_LED_RING_VALUE,
+                                          this->led_pixels_(), LED_RING_PAYLOAD_BYTES, nullptr)) {
+      return;  // queue full; loop() retries
     }
+    this->bus_scheduler_.queued(BUS_CLASS_LED);
+    this->led_frame_pending_ = false;
+    return;
   }
-  return "Unknown";
+#endif
+  this->led_frame_pending_ = false;
+  this->xmos_write_frame_(GPO_SERVICER_RESID, GPO_SERVICER_RESID_LED_RING_VALUE, this->led_frame_,
+                          LED_RING_PAYLOAD_BYTES, BUS_CLASS_LED);
 }
+#endif
 
-// =========================================================================
-//   Child Component Implementations
-// =========================================================================
+i2c::ErrorCode RespeakerXVF3800::bus_write_(BusClass bus_class, const uint8_t *data, size_t len) {
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+  LockGuard guard(this->transport_lock_);
+#endif
+  return this->timed_write_(bus_class, data, len);
+}
+
+i2c::ErrorCode RespeakerXVF3800::bus_read_(BusClass bus_class, uint8_t *data, size_t len) {
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+  LockGuard guard(this->transport_lock_);
+#endif
+  return this->timed_read_(bus_class, data, len);
+}
 
-// --- MuteSwitch Component ---
-void MuteSwitch::setup() {
-  ESP_LOGCONFIG(TAG, "Setting up Mute Switch...");
+i2c::ErrorCode RespeakerXVF3800::bus_request_(BusClass bus_class, const uint8_t *request, size_t request_len,
+                                              uint8_t *response, size_t response_len) {
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+  // One lock for both halves: a command the control task ran in between would get this response
+  LockGuard guard(this->transport_lock_);
+#endif
+  i2c::ErrorCode err = this->timed_write_(bus_class, request, request_len);
+  if (err == i2c::ERROR_OK) {
+    err = this->timed_read_(bus_class, response, response_len);
+  }
+  return err;
 }
 
-void MuteSwitch::dump_config() {
-  LOG_SWITCH("", "Respeaker Mute Switch", this);
+i2c::ErrorCode RespeakerXVF3800::timed_write_(BusClass bus_class, const uint8_t *data, size_t len) {
+  const uint32_t start = micros();
+  i2c::ErrorCode err = this->write(data, len);
+  const uint32_t duration = micros() - start;
+  this->bus_scheduler_.record(bus_class, len + 1, duration);
+  this->note_transaction_(err, duration);
+  return err;
 }
 
-void MuteSwitch::update() {
-  if (this->parent_ == nullptr) {
-    ESP_LOGW(TAG, "MuteSwitch parent not set");
+i2c::ErrorCode RespeakerXVF3800::timed_read_(BusClass bus_class, uint8_t *data, size_t len) {
+  const uint32_t start = micros();
+  i2c::ErrorCode err = this->read(data, len);
+  const uint32_t duration = micros() - start;
+  this->bus_scheduler_.record(bus_class, len + 1, duration);
+  this->note_transaction_(err, duration);
+  return err;
+}
+
+i2c::ErrorCode RespeakerXVF3800::bus_write_read_(BusClass bus_class, const uint8_t *write_data, size_t write_len,
+                                                 uint8_t *read_data, size_t read_len) {
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+  LockGuard guard(this->transport_lock_);
+#endif
+  const uint32_t start = micros();
+  i2c::ErrorCode err = this->write_read(write_data, write_len, read_data, read_len);
+  const uint32_t duration = micros() - start;
+  this->bus_scheduler_.record(bus_class, write_len + read_len + 2, duration);
+  this->note_transaction_(err, duration);
+  return err;
+}
+
+// Errors and slow transfers are counted apart: a transfer that completed is proof the XMOS is
+// there, however long it took (e.g. while the main loop waited on the transport lock).
+void RespeakerXVF3800::note_transaction_(i2c::ErrorCode err, uint32_t duration_us) {
+  if (err != i2c::ERROR_OK) {
+    if (this->consecutive_failures_.load(std::memory_order_relaxed) < UINT8_MAX) {
+      this->consecutive_failures_.fetch_add(1, std::memory_order_relaxed);
+    }
     return;
   }
-
-  bool mute_state = this->parent_->read_mute_status();
-  
-  if (this->state != mute_state) {
-    this->publish_state(mute_state);
+  this->consecutive_failures_.store(0, std::memory_order_relaxed);
+  if (duration_us > this->health_max_latency_us_) {
+    if (this->consecutive_slow_.load(std::memory_order_relaxed) < UINT8_MAX) {
+      this->consecutive_slow_.fetch_add(1, std::memory_order_relaxed);
+    }
+  } else {
+    this->consecutive_slow_.store(0, std::memory_order_relaxed);
   }
 }
 
-void MuteSwitch::write_state(bool state) {
-  ESP_LOGD(TAG, "MuteSwitch::write_state called with state: %s", state ? "ON" : "OFF");
-  ESP_LOGD(TAG, "Parent pointer: %p", this->parent_);
-  
-  if (this->parent_ == nullptr) {
-    ESP_LOGE(TAG, "MuteSwitch parent not set - cannot write mute status");
+// Escalates retry -> bus resync -> hard reset, one step per loop() pass so the main loop never
+// blocks for longer than a single probe. Async XMOS commands are refused until the XMOS answers again.
+void RespeakerXVF3800::health_loop_() {
+  if (!this->health_armed_ || this->dfu_busy_()) {
     return;
   }
-  
-  this->parent_->write_mute_status(state);
-  this->publish_state(state);
+  const uint32_t now = millis();
+  if (this->health_state_ == HEALTH_OK) {
+    // Slow transfers are only reported; recovery needs failed ones
+    const uint8_t slow = this->consecutive_slow_.load(std::memory_order_relaxed);
+    if (slow >= this->health_max_failures_ && !this->health_slow_reported_) {
+      ESP_LOGW(TAG, "%u transfers in a row took longer than %" PRIu32 "us", slow, this->health_max_latency_us_);
+      this->health_slow_reported_ = true;
+    } else if (slow == 0) {
+      this->health_slow_reported_ = false;
+    }
+    if (this->consecutive_failures_.load(std::memory_order_relaxed) < this->health_max_failures_) {
+      return;
+    }
+    ESP_LOGW(TAG, "XMOS unresponsive after %u failed transfers; recovering", this->health_max_failures_);
+    this->health_fault_ms_ = now;
+    this->enter_health_state_(HEALTH_RETRY, 0);
+    return;
+  }
+  if ((int32_t) (now - this->health_next_ms_) < 0) {
+    return;
+  }
+
+  switch (this->health_state_) {
+    case HEALTH_RETRY:
+      if (this->health_probe_()) {
+        this->restore_state_(false);
+      } else if (++this->health_attempts_ < 3) {
+        this->health_next_ms_ = now + (100u << this->health_attempts_);  // 200, 400ms
+      } else {
+        ESP_LOGW(TAG, "Retries failed; resyncing the I2C bus");
+        this->enter_health_state_(HEALTH_RECOVER_BUS, 250);
+      }
+      break;
+
+    case HEALTH_RECOVER_BUS:
+      // After the quiet period, a bare START/address/STOP lets a slave that lost track of a
+      // half-finished transfer re-synchronise before the next real request. This is not a full
+      // bus recovery: the pins belong to the I2C driver, so SCL can not be clocked by hand to
+      // free a slave holding SDA low; that case is left to the reset pin.
+      this->bus_write_(BUS_CLASS_CONTROL, nullptr, 0);
+      if (this->health_probe_()) {
+        this->restore_state_(false);
+      } else if (this->reset_pin_ != nullptr) {
+        ESP_LOGW(TAG, "Bus resync failed; resetting the XMOS");
+        this->reset_pin_->digital_write(false);
+        this->enter_health_state_(HEALTH_RESET, 10);
+      } else {
+        ESP_LOGE(TAG, "Bus resync failed and no reset pin is configured");
+        this->enter_health_state_(HEALTH_DEGRADED, 5000);
+      }
+      break;
+
+    case HEALTH_RESET:
+      this->reset_pin_->digital_write(true);
+      this->enter_health_state_(HEALTH_BOOTING, 3000);  // same boot time as in setup()
+      break;
+
+    case HEALTH_BOOTING:
+      if (this->health_probe_()) {
+        this->restore_state_(true);
+      } else if (++this->health_attempts_ < 10) {
+        this->health_next_ms_ = now + 500;
+      } else {
+        ESP_LOGE(TAG, "XMOS did not come back after the reset");
+        this->enter_health_state_(HEALTH_DEGRADED, 5000);
+      }
+      break;
+
+    case HEALTH_DEGRADED:
+      // Whatever brought it back, assume the XMOS lost its configuration
+      if (this->health_probe_()) {
+        this->restore_state_(true);
+      } else {
+        this->health_next_ms_ = now + 5000;
+      }
+      break;
+
+    default:
+      break;
+  }
 }
 
-// --- DFUVersionTextSensor Component ---
-void DFUVersionTextSensor::setup() {
-  ESP_LOGCONFIG(TAG, "Setting up DFU Version Text Sensor...");
+bool RespeakerXVF3800::health_probe_() {
+  uint8_t version[3];
+  return this->read_version_(BUS_CLASS_CONTROL, version);
 }
 
-void DFUVersionTextSensor::dump_config() {
-  LOG_TEXT_SENSOR("", "Respeaker DFU Version", this);
+void RespeakerXVF3800::enter_health_state_(HealthState state, uint32_t delay_ms) {
+  this->health_state_ = state;
+  this->health_attempts_ = 0;
+  this->health_next_ms_ = millis() + delay_ms;
 }
 
-void DFUVersionTextSensor::update() {
-  if (this->parent_ == nullptr) {
-    ESP_LOGW(TAG, "DFUVersionTextSensor parent not set");
-    return;
+void RespeakerXVF3800::restore_state_(bool rebooted) {
+  this->consecutive_failures_.store(0, std::memory_order_relaxed);
+  this->consecutive_slow_.store(0, std::memory_order_relaxed);
+  this->health_state_ = HEALTH_OK;
+  this->health_recoveries_++;
+  ESP_LOGI(TAG, "XMOS recovered in %" PRIu32 "ms%s", millis() - this->health_fault_ms_,
+           rebooted ? " (reset)" : "");
+
+  if (rebooted) {
+    this->apply_audio_config_();
+#ifdef USE_RESPEAKER_XVF3800_ACOUSTIC_PROFILES
+    if (this->active_acoustic_profile_ != nullptr) {
+      this->apply_acoustic_profile(this->active_acoustic_profile_);
+    }
+#endif
   }
-  
-  std::string version = this->parent_->read_dfu_version();
-  if (this->get_raw_state() != version) {
-    this->publish_state(version);
+  // Writes refused or lost during the outage are sent again
+#ifdef USE_RESPEAKER_XVF3800_MUTE_SWITCH
+  if (this->mute_switch_ != nullptr) {
+    this->write_mute_status(this->mute_switch_->state);
+  }
+#endif
+#ifdef USE_RESPEAKER_XVF3800_BEAM_LOCK
+  if (this->beam_locked_) {
+    this->write_beam_lock_(this->locked_azimuth_);
+  }
+#endif
+#ifdef USE_RESPEAKER_XVF3800_LED_RING
+  if (this->led_frame_valid_) {
+    this->led_frame_pending_ = true;
   }
+#endif
 }
 
-// --- LEDBeamSensor Component ---
-void LEDBeamSensor::setup() {
-  ESP_LOGCONFIG(TAG, "Setting up LED Beam Sensor...");
+void RespeakerXVF3800::dump_trace() {
+#ifdef USE_RESPEAKER_XVF3800_TRACE
+  this->trace_.dump();
+#else
+  ESP_LOGW(TAG, "Tracing is not enabled");
+#endif
 }
 
-void LEDBeamSensor::dump_config() {
-  LOG_SENSOR("", "Respeaker LED Beam Direction", this);
+void RespeakerXVF3800::publish_bus_utilization_() {
+  ESP_LOGD(TAG, "Bus bytes: control=%" PRIu32 " audio=%" PRIu32 " led=%" PRIu32 " telemetry=%" PRIu32 " dfu=%" PRIu32
+                ", deferred led=%" PRIu32 " telemetry=%" PRIu32,
+           this->bus_scheduler_.get_bytes(BUS_CLASS_CONTROL), this->bus_scheduler_.get_bytes(BUS_CLASS_AUDIO),
+           this->bus_scheduler_.get_bytes(BUS_CLASS_LED), this->bus_scheduler_.get_bytes(BUS_CLASS_TELEMETRY),
+           this->bus_scheduler_.get_bytes(BUS_CLASS_DFU), this->bus_scheduler_.get_deferred(BUS_CLASS_LED),
+           this->bus_scheduler_.get_deferred(BUS_CLASS_TELEMETRY));
+  float utilization = this->bus_scheduler_.take_utilization() * 100.0f;
+  if (this->bus_utilization_sensor_ != nullptr) {
+    this->bus_utilization_sensor_->publish_state(utilization);
+  }
 }
 
-void LEDBeamSensor::update() {
+// =========================================================================
+//   Child Entity Implementations
+// =========================================================================
+
+#ifdef USE_RESPEAKER_XVF3800_MUTE_SWITCH
+// --- MuteSwitch ---
+void MuteSwitch::write_state(bool state) {
+  ESP_LOGD(TAG, "MuteSwitch::write_state called with state: %s", state ? "ON" : "OFF");
+
   if (this->parent_ == nullptr) {
-    ESP_LOGW(TAG, "LEDBeamSensor parent not set");
+    ESP_LOGE(TAG, "MuteSwitch parent not set - cannot write mute status");
     return;
   }
-  
-  int led_index = this->parent_->read_led_beam_direction();
-  if (led_index >= 0 && led_index <= 11) {
-    if (!this->has_state() || this->get_raw_state() != led_index) {
-      this->publish_state(led_index);
-    }
-  // } else {
-  //   ESP_LOGW(TAG, "Invalid LED beam direction: %d", led_index);
-  }
+
+  this->parent_->write_mute_status(state);
+  this->publish_state(state);
 }
+#endif
 
 }  // namespace respeaker_xvf3800
 }  // namespace esphome
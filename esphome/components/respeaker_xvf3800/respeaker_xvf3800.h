@@ -13,7 +13,38 @@
 #include "esphome/core/component.h"
 #include "esphome/core/defines.h"
 #include "esphome/core/hal.h"
+#include "beam_tracking.h"
+#include "bus_scheduler.h"
+#include "capture.h"
+#include "control_task.h"
+#include "dfu_scheduler.h"
+#include "frame_packing.h"
+#include "exclusion_zones.h"
+#include "led_animation.h"
+#include "poll_table.h"
+#include "read_sweep.h"
+#include "trace.h"
+#include "esphome/core/helpers.h"
+#ifdef USE_RESPEAKER_XVF3800_AEC_CALIBRATION
+#include "esphome/components/speaker/speaker.h"
+#include "esphome/core/preferences.h"
+#endif
+#ifdef USE_RESPEAKER_XVF3800_EXCLUSION_ZONES
+#include "esphome/core/preferences.h"
+#endif
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+#include "esphome/core/preferences.h"
+#ifdef USE_TIME
+#include "esphome/components/time/real_time_clock.h"
+#endif
+#ifdef USE_VOICE_ASSISTANT
+#include "esphome/components/voice_assistant/voice_assistant.h"
+#endif
+#endif
+#include <atomic>
 #include <cstring>
+#include <string>
+#include <vector>
 
 namespace esphome {
 namespace respeaker_xvf3800 {
@@ -30,7 +61,19 @@ static const uint8_t CONFIGURATION_COMMAND_READ_BIT = 0x80;
 static const uint8_t DFU_COMMAND_READ_BIT = 0x80;
 
 static const uint16_t DFU_TIMEOUT_MS = 4000;
+static const uint32_t DFU_RETRY_BACKOFF_MS = 5000;  // doubled for every further attempt
+// Boot after the fallback reboot: the 3s setup() allows, plus the probes the health watchdog allows
+static const uint32_t DFU_FALLBACK_BOOT_MS = 8000;
+static const uint32_t DFU_SCHEDULE_CHECK_MS = 1000;
+// Update duration estimate until an update completed on this array; measured rates replace it
+static const uint32_t DFU_DEFAULT_BYTES_PER_S = 4096;
+static const uint32_t DFU_REBOOT_ESTIMATE_MS = 5000;  // reboot and version check after the last block
 static const uint16_t MAX_XFER = 128;  // maximum number of bytes we can transfer per block
+static const uint8_t XMOS_MAX_READ_BYTES = 64;  // largest parameter payload read in one request
+static const uint8_t XMOS_MAX_WRITE_BYTES = 64;  // largest parameter payload written in one request
+// DFU_DNLOAD frame: header, block length, reserved byte, block (zero padded)
+static const uint8_t DFU_DNLOAD_FRAME_BYTES = XMOS_HEADER_BYTES + 2 + MAX_XFER;
+static const uint8_t LED_RING_PAYLOAD_BYTES = 48;  // 12 x RGB0
 
 // Original XVF3800 constants
 const uint8_t GPO_SERVICER_RESID = 20;
@@ -49,6 +92,29 @@ const uint8_t AEC_AZIMUTH_VALUES_CMD = 75;
 const uint8_t AEC_FIXEDBEAMS_ONOFF_CMD = 37;
 const uint8_t AEC_FIXEDBEAMS_AZIMUTH_CMD = 81;
 
+// AEC state used by the reference-delay calibration.
+// AEC_AECCONVERGED   : (33, 3, 1, ro, int32)  — 1 once the echo canceller has converged
+// AEC_SPENERGY_VALUES: (33, 80, 4, ro, float) — per-beam post-AEC energy, same slot order as cmd 75
+const uint8_t AEC_AECCONVERGED_CMD = 3;
+const uint8_t AEC_SPENERGY_VALUES_CMD = 80;
+
+// Audio manager output routing. Each OP_L/OP_R value is a (category, source) pair;
+// OP_PACKED/OP_UPSAMPLE take one flag per output channel (L, R).
+const uint8_t AUDIO_MGR_SERVICER_RESID = 35;
+const uint8_t AUDIO_MGR_OP_PACKED_CMD = 13;
+const uint8_t AUDIO_MGR_OP_UPSAMPLE_CMD = 14;
+const uint8_t AUDIO_MGR_OP_L_CMD = 15;
+const uint8_t AUDIO_MGR_OP_R_CMD = 19;
+// AUDIO_MGR_SYS_DELAY: (35, 26, 1, rw, int32) — playback-to-reference delay in samples
+const uint8_t AUDIO_MGR_SYS_DELAY_CMD = 26;
+
+// Sample layout in the I2S output words. The word width (32 bits) is fixed by the firmware build.
+// Must match OUTPUT_WORD_FORMATS in __init__.py
+enum OutputWordFormat : uint8_t {
+  OUTPUT_WORD_INT32 = 0,  // one sample per word at the output sample rate
+  OUTPUT_WORD_PACKED,     // 16 kHz samples packed into the 48 kHz frame (OP_PACKED)
+};
+
 const uint8_t RESID_LED = 0x0C;
 const uint8_t RESID_DFU_VERSION = 0xFE;
 const uint8_t I2C_COMMAND_READ_BIT = 0x80;
@@ -73,6 +139,12 @@ enum RespeakerXVF3800UpdaterStatus : uint8_t {
   UPDATE_IN_PROGRESS,
   UPDATE_REBOOT_PENDING,
   UPDATE_VERIFY_NEW_VERSION,
+  // Recovery after a failed update, see dfu_recover_()
+  UPDATE_RETRY_BACKOFF,
+  UPDATE_FALLBACK_INVALIDATE,
+  UPDATE_FALLBACK_MANIFEST,
+  UPDATE_FALLBACK_REBOOT,
+  UPDATE_FALLBACK_VERIFY,
 };
 
 // Configuration enums from the XMOS firmware's src/configuration/configuration_servicer.h
@@ -133,6 +205,27 @@ enum DfuCommands : uint8_t {
   DFU_CONTROLLER_SERVICER_RESID_DFU_REBOOT = 89,
 };
 
+// I2C health watchdog escalation, see health_loop_()
+enum HealthState : uint8_t {
+  HEALTH_OK,
+  HEALTH_RETRY,        // probing with backoff
+  HEALTH_RECOVER_BUS,  // quiet period, then an address-only transaction to resync the slave (no SCL clocking)
+  HEALTH_RESET,        // reset pin held low
+  HEALTH_BOOTING,      // waiting for the XMOS to come back after the reset
+  HEALTH_DEGRADED,     // nothing worked; slow periodic probe
+};
+
+#if defined(USE_RESPEAKER_XVF3800_TELEMETRY) || defined(USE_RESPEAKER_XVF3800_CAPTURE)
+// Reads of a telemetry frame and of a capture record, see read_status_()
+enum StatusRead : uint8_t {
+  STATUS_READ_AZIMUTH,  // cmd 75, four floats
+  STATUS_READ_VNR,
+  STATUS_READ_GPO,
+  STATUS_READ_COUNT,
+};
+static const size_t STATUS_READ_PAYLOAD = 4 * sizeof(float) + 1 + GPO_GPO_READ_NUM_BYTES;
+#endif
+
 enum DFUAutomationState {
   DFU_COMPLETE = 0,
   DFU_START,
@@ -140,47 +233,70 @@ enum DFUAutomationState {
   DFU_ERROR,
 };
 
-// --- Component Classes ---
-
-// MuteSwitch class that handles the mute functionality
-class MuteSwitch : public switch_::Switch, public PollingComponent {
- public:
-  void set_parent(RespeakerXVF3800 *parent) {
-    parent_ = parent;
-    ESP_LOGD("respeaker_xvf3800", "MuteSwitch parent set to %p", parent);
-  }
-  void setup() override;
-  void write_state(bool state) override;
-  void update() override;
-  void dump_config() override;
+#ifdef USE_RESPEAKER_XVF3800_ACOUSTIC_PROFILES
+// A named set of parameter writes compiled from YAML. `frames` holds back-to-back
+// [resid, cmd, length, payload...] records that go on the wire as they are;
+// `shadow_offsets` gives each record's slot in the hub's shadow of written values.
+struct AcousticProfile {
+  const char *name;
+  const uint8_t *frames;
+  uint16_t frames_len;
+  const uint16_t *shadow_offsets;
+};
+#endif
 
- protected:
-  RespeakerXVF3800 *parent_{nullptr};
+#ifdef USE_RESPEAKER_XVF3800_DSP_DIAGNOSTICS
+// Must match DSP_VALUE_TYPES in __init__.py
+enum DspValueType : uint8_t {
+  DSP_VALUE_UINT8 = 0,
+  DSP_VALUE_INT32,
+  DSP_VALUE_UINT32,
+  DSP_VALUE_FLOAT,
 };
 
-// DFUVersionTextSensor class to read the firmware version
-class DFUVersionTextSensor : public text_sensor::TextSensor, public PollingComponent {
- public:
-  void set_parent(RespeakerXVF3800 *parent) { parent_ = parent; }
-  void setup() override;
-  void update() override;
-  void dump_config() override;
+// One status parameter read per diagnostics sweep; `offset` locates its payload in the sweep buffer
+struct DspRead {
+  uint8_t resid;
+  uint8_t cmd;
+  uint8_t length;
+  uint16_t offset;
+  bool ok;
+};
 
- protected:
-  RespeakerXVF3800 *parent_{nullptr};
+// A sensor fed from one value of a DspRead
+struct DspDiagnostic {
+  sensor::Sensor *sensor;
+  uint8_t read;
+  DspValueType type;
+  uint8_t offset;  // bytes into the read's payload
+  float min_change;
 };
+#endif
 
-// LEDBeamSensor class to read the active LED beam direction
-class LEDBeamSensor : public sensor::Sensor, public PollingComponent {
+// --- Component Classes ---
+
+#ifdef USE_RESPEAKER_XVF3800_MUTE_SWITCH
+// MuteSwitch class that handles the mute functionality
+// The hub polls its state (GPIO30) from the poll table
+class MuteSwitch : public switch_::Switch {
  public:
   void set_parent(RespeakerXVF3800 *parent) { parent_ = parent; }
-  void setup() override;
-  void update() override;
-  void dump_config() override;
+  void write_state(bool state) override;
 
  protected:
   RespeakerXVF3800 *parent_{nullptr};
 };
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_DFU_VERSION
+// Running XMOS firmware version, polled by the hub
+class DFUVersionTextSensor : public text_sensor::TextSensor {};
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_LED_BEAM_SENSOR
+// LED (0-11) the tracked beam points to, polled by the hub
+class LEDBeamSensor : public sensor::Sensor {};
+#endif
 
 // --- Main Hub Class ---
 
@@ -188,7 +304,12 @@ class RespeakerXVF3800 : public i2c::I2CDevice, public Component {
  public:
   void setup() override;
   bool can_proceed() override {
-    return this->is_failed() || (this->version_read_() && (this->versions_match_() || !this->firmware_bin_is_valid_()));
+#ifdef USE_RESPEAKER_XVF3800_DFU
+    return this->is_failed() || (this->version_read_() && (this->versions_match_() || !this->firmware_bin_is_valid_() ||
+                                                           this->dfu_fell_back_ || this->is_update_pending()));
+#else
+    return this->is_failed() || this->version_read_();
+#endif
   }
   void dump_config() override;
   float get_setup_priority() const override { return setup_priority::HARDWARE - 1; }
@@ -200,12 +321,56 @@ class RespeakerXVF3800 : public i2c::I2CDevice, public Component {
   }
 #endif
 
+  // Position among the configured hubs; keeps per-hub preferences apart
+  void set_instance_index(uint8_t index) { this->instance_index_ = index; }
+
+  // Active-low XMOS reset (RST_N); used by the health watchdog as the last recovery step
   void set_reset_pin(GPIOPin *reset_pin) { reset_pin_ = reset_pin; }
+  // `max_failures` consecutive I2C errors start the recovery. Transfers slower than
+  // `max_latency_us` are counted apart and only logged; a slow answer is still an answer.
+  void set_health_thresholds(uint8_t max_failures, uint32_t max_latency_us) {
+    this->health_max_failures_ = max_failures;
+    this->health_max_latency_us_ = max_latency_us;
+  }
+  bool is_healthy() const { return this->health_state_ == HEALTH_OK; }
 
+  // Hot-path trace; nullptr when tracing is compiled out
+  TraceBuffer *get_trace() {
+#ifdef USE_RESPEAKER_XVF3800_TRACE
+    return &this->trace_;
+#else
+    return nullptr;
+#endif
+  }
+  void dump_trace();
+
+  // Shared bus scheduling; the AIC3104 accounts its traffic here as well
+  BusScheduler *get_bus_scheduler() { return &this->bus_scheduler_; }
+  // Held around every bus transfer while the control task owns the transport; other drivers on
+  // the same bus (the AIC3104) take it too. nullptr without the control task.
+  Mutex *get_transport_lock() {
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+    return &this->transport_lock_;
+#else
+    return nullptr;
+#endif
+  }
+  void set_bus_frequency(uint32_t frequency) { this->bus_scheduler_.set_frequency(frequency); }
+  void set_bus_budget(BusClass bus_class, uint8_t percent) { this->bus_scheduler_.set_budget(bus_class, percent); }
+  void set_bus_report_interval(uint32_t interval) { this->bus_report_interval_ = interval; }
+  void set_bus_utilization_sensor(sensor::Sensor *sensor) { this->bus_utilization_sensor_ = sensor; }
+  // Bytes on the wire (address bytes included) for a parameter read/write with `payload` bytes
+  static constexpr size_t read_bus_bytes(size_t payload) { return 3 + 1 + payload + 2; }
+  static constexpr size_t write_bus_bytes(size_t payload) { return 3 + payload + 1; }
+
+#ifdef USE_RESPEAKER_XVF3800_DFU
   void set_firmware_bin(const uint8_t *data, const uint32_t len) {
     this->firmware_bin_ = data;
     this->firmware_bin_length_ = len;
   }
+  // Keys the remembered factory fallback, so a different image is tried again
+  void set_firmware_md5(const char *md5) { this->firmware_bin_md5_ = md5; }
+#endif
 
   #ifdef USE_BINARY_SENSOR
   void set_mute_state(binary_sensor::BinarySensor *mute_state) { this->mute_state_ = mute_state; }
@@ -214,15 +379,164 @@ class RespeakerXVF3800 : public i2c::I2CDevice, public Component {
   void set_firmware_version(text_sensor::TextSensor* firmware_version) {
     this->firmware_version_ = firmware_version;
   }
-  
+
+#ifdef USE_RESPEAKER_XVF3800_DFU
+  // Failed updates are retried `max_retries` times before falling back to the factory image
+  void set_dfu_max_retries(uint8_t max_retries) { this->dfu_max_retries_ = max_retries; }
+
   void set_firmware_version(uint8_t major, uint8_t minor, uint8_t patch) {
     this->firmware_bin_version_major_ = major;
     this->firmware_bin_version_minor_ = minor;
     this->firmware_bin_version_patch_ = patch;
   }
+#endif
+
+  // Audio manager output configuration, written once the firmware version is confirmed.
+  // Upsampling is turned off for 16 kHz output.
+  void set_output_config(uint8_t left_category, uint8_t left_source, uint8_t right_category, uint8_t right_source,
+                         uint32_t sample_rate, OutputWordFormat word_format) {
+    this->output_left_[0] = left_category;
+    this->output_left_[1] = left_source;
+    this->output_right_[0] = right_category;
+    this->output_right_[1] = right_source;
+    this->output_sample_rate_ = sample_rate;
+    this->output_word_format_ = word_format;
+  }
 
   void start_dfu_update();
-  uint8_t read_vnr();
+  // Starts the update once the schedule allows it; without a `schedule` block, right away
+  void request_dfu_update();
+  // An update is deferred by the schedule; the array keeps running the current firmware meanwhile
+  bool is_update_pending() const {
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+    return this->dfu_schedule_.is_pending();
+#else
+    return false;
+#endif
+  }
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+  void set_dfu_window(uint16_t start_minute, uint16_t end_minute) {
+    this->dfu_schedule_.set_window(start_minute, end_minute);
+  }
+  void set_dfu_quiet_vnr(uint8_t max_vnr, uint32_t hold_ms) { this->dfu_schedule_.set_quiet_vnr(max_vnr, hold_ms); }
+  void set_dfu_max_defer(uint32_t ms) { this->dfu_schedule_.set_max_defer(ms); }
+#ifdef USE_TIME
+  void set_dfu_time(time::RealTimeClock *time) { this->dfu_time_ = time; }
+#endif
+#ifdef USE_VOICE_ASSISTANT
+  void set_dfu_voice_assistant(voice_assistant::VoiceAssistant *voice_assistant) {
+    this->dfu_voice_assistant_ = voice_assistant;
+  }
+#endif
+#ifdef USE_BINARY_SENSOR
+  void set_update_pending_sensor(binary_sensor::BinarySensor *sensor) { this->update_pending_sensor_ = sensor; }
+#endif
+  void set_update_duration_sensor(sensor::Sensor *sensor) { this->update_duration_sensor_ = sensor; }
+  // Expected duration of a full update, from the rate of the last update on this array
+  uint32_t get_update_estimate_ms() const {
+    return (uint64_t) this->firmware_bin_length_ * 1000 / this->dfu_rate_ + DFU_REBOOT_ESTIMATE_MS;
+  }
+#endif
+  // Voice-to-noise ratio estimate (0-100). Returns false if the read failed, so a failure
+  // is never mistaken for a VNR of 0.
+  bool read_vnr(uint8_t *vnr);
+
+#ifdef USE_RESPEAKER_XVF3800_VNR
+  void set_vnr_update_interval(uint32_t interval) { this->vnr_interval_ = interval; }
+  void set_vnr_sensor(sensor::Sensor *sensor) { this->vnr_sensor_ = sensor; }
+#ifdef USE_BINARY_SENSOR
+  void set_voice_activity_sensor(binary_sensor::BinarySensor *sensor) { this->voice_activity_sensor_ = sensor; }
+#endif
+  // Voice activity turns on once VNR stays >= `on_threshold` for `attack_ms` and off once it
+  // stays below `off_threshold` for `release_ms`
+  void set_voice_activity_config(uint8_t on_threshold, uint8_t off_threshold, uint32_t attack_ms,
+                                 uint32_t release_ms) {
+    this->vad_on_threshold_ = on_threshold;
+    this->vad_off_threshold_ = off_threshold;
+    this->vad_attack_ms_ = attack_ms;
+    this->vad_release_ms_ = release_ms;
+  }
+#endif
+#ifdef USE_RESPEAKER_XVF3800_TELEMETRY
+  // Telemetry frame, published only when it changed:
+  //   a=<beam 1>,<beam 2>,<free-running>,<auto-select>;v=<vnr>;m=<mute>;g=<GPO bytes, hex>;l=<beam lock>;
+  //   b=<bus utilization %>,<consecutive failures>,<recoveries>
+  // Azimuths are whole degrees; a field that could not be read is "-".
+  void set_telemetry_sensor(text_sensor::TextSensor *sensor) { this->telemetry_sensor_ = sensor; }
+  void set_telemetry_interval(uint32_t interval) { this->telemetry_interval_ = interval; }
+#endif
+  // Speech currently detected by the VNR hysteresis; always false without a `vnr` block
+  bool is_voice_active() const { return this->voice_active_; }
+
+#ifdef USE_RESPEAKER_XVF3800_BEAM_ENERGY
+  void set_beam_energy_update_interval(uint32_t interval) { this->beam_energy_interval_ = interval; }
+  // `beam` is the slot of AEC_SPENERGY_VALUES (same order as the azimuth slots)
+  void set_beam_energy_sensor(uint8_t beam, sensor::Sensor *sensor) { this->beam_energy_sensors_[beam] = sensor; }
+  // Levels mapped onto the energy LED effect, in dB
+  void set_beam_energy_range(float min_db, float max_db) {
+    this->beam_energy_min_db_ = min_db;
+    this->beam_energy_max_db_ = max_db;
+  }
+#ifdef USE_RESPEAKER_XVF3800_LED_RING
+  void set_energy_effect_config(uint32_t color, uint32_t release_ms) {
+    this->energy_effect_color_ = color;
+    this->energy_effect_release_ms_ = release_ms;
+  }
+#endif
+#endif
+  // Lights an arc around the beam direction whose width follows the beam's speech energy.
+  // Rendered from the energy reads, so it costs no audio processing on the ESP32.
+  // LED animations take precedence while they play. `brightness` is 0-1.
+  void start_energy_effect(float brightness = 1.0f);
+  // Stops the effect and clears the ring
+  void stop_energy_effect();
+
+#ifdef USE_RESPEAKER_XVF3800_DSP_DIAGNOSTICS
+  // AEC / audio manager status parameters, read in one batch per interval. Each parameter is read
+  // once however many sensors use it; a sensor publishes when its value changed by at least
+  // `min_change` (any change with the default of 0).
+  void set_dsp_diagnostics_interval(uint32_t interval) { this->dsp_interval_ = interval; }
+  void add_dsp_read(uint8_t resid, uint8_t cmd, uint8_t length) {
+    this->dsp_reads_.push_back({resid, cmd, length, (uint16_t) this->dsp_values_.size(), false});
+    this->dsp_values_.resize(this->dsp_values_.size() + length);
+  }
+  void add_dsp_diagnostic(sensor::Sensor *sensor, uint8_t read, DspValueType type, uint8_t offset,
+                          float min_change) {
+    this->dsp_diagnostics_.push_back({sensor, read, type, offset, min_change});
+  }
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_EXCLUSION_ZONES
+  void add_exclusion_zone(uint16_t from_degrees, uint16_t to_degrees) {
+    this->exclusion_zones_.add_zone(from_degrees, to_degrees);
+  }
+  void set_exclusion_window(uint32_t window_ms) { this->exclusion_zones_.set_window(window_ms); }
+  void set_exclusion_learning(float threshold, uint32_t half_life_ms) {
+    this->exclusion_zones_.set_learning(threshold, half_life_ms);
+  }
+  void set_exclusion_update_interval(uint32_t interval) { this->exclusion_interval_ = interval; }
+#endif
+  // Whether the wake word detected at `wake_ms` (millis()) came from an excluded direction.
+  // Only looks at directions already sampled, so it is cheap enough for on_wake_word_detected.
+  // The wake is remembered for report_false_wake(). Always false without `exclusion_zones`.
+  bool is_wake_excluded(uint32_t wake_ms);
+  // Counts the last checked wake as false, so its direction is learned as a noise source
+  void report_false_wake();
+  void clear_learned_exclusions();
+
+#ifdef USE_RESPEAKER_XVF3800_CAPTURE
+  void set_capture_config(uint32_t records, uint32_t interval) {
+    this->capture_capacity_ = records;
+    this->capture_interval_ = interval;
+  }
+#endif
+  // Binary capture of the beam-tracking inputs (cmd 75 azimuths, VNR, mute and the status of
+  // each read) into a ring buffer, for offline replay with misc/capture_replay.cpp.
+  // Starting clears the previous capture.
+  void start_capture();
+  void stop_capture();
+  // Stops the capture and logs it as hex lines over the next loop passes (format in capture_format.h)
+  void export_capture();
 
   // Public methods for child components
   bool read_gpo_values(uint8_t *buffer, uint8_t *status);
@@ -230,41 +544,256 @@ class RespeakerXVF3800 : public i2c::I2CDevice, public Component {
   bool read_mute_status();
   void write_mute_status(bool value);
   
+#ifdef USE_RESPEAKER_XVF3800_LED_RING
   // Individual LED ring control (12 LEDs)
   void set_led_ring(uint32_t *rgb_array);
-  
-  std::string read_dfu_version();
-  
+#endif
+
+  // Plays a keyframe animation from the `led_animations` tables, replacing any running one.
+  // `brightness` is 0-1. Frames go out through set_led_ring() every frame interval.
+  bool play_led_animation(const std::string &name, float brightness = 1.0f);
+  // Stops the animation and leaves its last frame on the ring
+  void stop_led_animation();
+#ifdef USE_RESPEAKER_XVF3800_LED_ANIMATIONS
+  void add_led_animation(const char *name, const uint8_t *keyframes, uint8_t keyframe_count, bool loop) {
+    this->led_animations_.add(name, keyframes, keyframe_count, loop);
+  }
+  void set_led_animation_interval(uint32_t interval) { this->led_animation_interval_ = interval; }
+#endif
+
   // Read LED beam direction (0-11)
   int read_led_beam_direction();
+  // Maps an AEC azimuth (radians) to the nearest of the 12 LEDs
+  static int azimuth_to_led_index(float radians);
 
+  // Queued XMOS parameter access. With the control task the transfer runs on the worker and
+  // the completion fires from loop(); without it both happen before returning. Returns false
+  // only if the command could not be queued.
+  bool xmos_write_async(BusClass bus_class, uint8_t resid, uint8_t cmd, const uint8_t *value, uint8_t write_byte_num,
+                        XmosCompletion &&callback = nullptr);
+  bool xmos_read_async(BusClass bus_class, uint8_t resid, uint8_t cmd, uint8_t read_byte_num,
+                       XmosCompletion &&callback);
+
+#ifdef USE_RESPEAKER_XVF3800_BEAM_LOCK
   // Beam lock: pin the AEC beam to the current azimuth for the duration of an utterance,
   // then release it. Intended to be called from voice_assistant lambdas.
   void lock_beam();
   void unlock_beam();
+#endif
+  bool is_beam_locked() const {
+#ifdef USE_RESPEAKER_XVF3800_BEAM_LOCK
+    return this->beam_locked_;
+#else
+    return false;
+#endif
+  }
+
+  // AEC reference-delay calibration: plays a noise probe through the calibration speaker
+  // while sweeping AUDIO_MGR_SYS_DELAY, keeps the delay with the best AEC convergence
+  // (lowest residual energy on ties) and stores it in flash.
+  void start_aec_calibration();
+  bool is_calibrating() const;
+  int32_t get_aec_delay() const { return this->aec_delay_; }
+  // Called with true right before the probe starts playing and with false once it stopped, so
+  // a DAC that powers down while idle is awake for the measurement
+  void add_on_calibration_callback(std::function<void(bool)> &&callback) {
+#ifdef USE_RESPEAKER_XVF3800_AEC_CALIBRATION
+    this->calibration_callback_.add(std::move(callback));
+#endif
+  }
+
+#ifdef USE_RESPEAKER_XVF3800_AEC_CALIBRATION
+  void set_calibration_speaker(speaker::Speaker *speaker) { this->calibration_speaker_ = speaker; }
+  void set_calibration_range(int32_t min_delay, int32_t max_delay, int32_t step) {
+    this->calibration_min_delay_ = min_delay;
+    this->calibration_max_delay_ = max_delay;
+    this->calibration_step_ = step;
+  }
+  void set_calibration_dwell(uint32_t dwell_ms) { this->calibration_dwell_ms_ = dwell_ms; }
+#endif
+
+  // Writes all parameters of a named acoustic profile back to back, skipping those the
+  // hub already set to the target value. Returns false if the profile is unknown or a write failed.
+  bool apply_acoustic_profile(const std::string &name);
+
+#ifdef USE_RESPEAKER_XVF3800_ACOUSTIC_PROFILES
+  void add_acoustic_profile(const char *name, const uint8_t *frames, uint16_t frames_len,
+                            const uint16_t *shadow_offsets) {
+    this->acoustic_profiles_.push_back({name, frames, frames_len, shadow_offsets});
+  }
+  void set_acoustic_shadow_size(size_t size) { this->acoustic_shadow_.resize(size); }
+  void set_profile_latency_sensor(sensor::Sensor *sensor) { this->profile_latency_sensor_ = sensor; }
+#endif
 
-  // Setters for child components
-  void set_mute_switch(MuteSwitch *mute_switch) { mute_switch_ = mute_switch; }
-  void set_dfu_version_sensor(DFUVersionTextSensor *dfu_version_sensor) { dfu_version_sensor_ = dfu_version_sensor; }
-  void set_led_beam_sensor(LEDBeamSensor *led_beam_sensor) { led_beam_sensor_ = led_beam_sensor; }
+  // Setters for child entities; the hub polls each of them every `interval` ms from its poll table
+#ifdef USE_RESPEAKER_XVF3800_MUTE_SWITCH
+  void set_mute_switch(MuteSwitch *mute_switch, uint32_t interval) {
+    this->mute_switch_ = mute_switch;
+    this->mute_switch_interval_ = interval;
+  }
+#endif
+#ifdef USE_RESPEAKER_XVF3800_DFU_VERSION
+  void set_dfu_version_sensor(DFUVersionTextSensor *dfu_version_sensor, uint32_t interval) {
+    this->dfu_version_sensor_ = dfu_version_sensor;
+    this->dfu_version_interval_ = interval;
+  }
+#endif
+#ifdef USE_RESPEAKER_XVF3800_LED_BEAM_SENSOR
+  void set_led_beam_sensor(LEDBeamSensor *led_beam_sensor, uint32_t interval) {
+    this->led_beam_sensor_ = led_beam_sensor;
+    this->led_beam_interval_ = interval;
+  }
+#endif
 
  protected:
 #ifdef USE_RESPEAKER_XVF3800_STATE_CALLBACK
   CallbackManager<void(DFUAutomationState, float, RespeakerXVF3800UpdaterStatus)> state_callback_{};
 #endif
+  // Firmware update (or its recovery) running; always false without a `firmware` block
+  bool dfu_busy_() const {
+#ifdef USE_RESPEAKER_XVF3800_DFU
+    return this->dfu_update_status_ != UPDATE_OK;
+#else
+    return false;
+#endif
+  }
+#ifdef USE_RESPEAKER_XVF3800_DFU
+  // Runs one step of the update state machine from loop()
+  void dfu_loop_();
   RespeakerXVF3800UpdaterStatus dfu_update_send_block_();
+  // Sets up the first block of an update attempt
+  void begin_dfu_update_();
+  // Called once per failed attempt: resets the DFU state machine, then either schedules a
+  // retry or starts the factory-image fallback
+  void dfu_recover_();
+  // Makes the upgrade slot unbootable (one erased-flash block, then manifest) and reboots,
+  // so the XMOS boot loader starts the factory image
+  RespeakerXVF3800UpdaterStatus dfu_fallback_step_();
+  void save_dfu_fallback_(uint32_t image);
   uint32_t load_buf_(uint8_t *buf, const uint8_t max_len, const uint32_t offset);
   bool firmware_bin_is_valid_() { return this->firmware_bin_ != nullptr && this->firmware_bin_length_; }
-  bool version_read_();
   bool versions_match_();
 
   bool dfu_get_status_();
-  bool dfu_get_version_();
   bool dfu_reboot_();
   bool dfu_set_alternate_();
+  bool dfu_command_(uint8_t cmd, const char *name);
   bool dfu_check_if_ready_();
+#endif
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+  // Starts a deferred update when the schedule allows it, otherwise samples VNR for the next check
+  void dfu_schedule_check_();
+  void publish_dfu_schedule_();
+#endif
+  bool version_read_();
+  // Synchronous GETVERSION; fills `version` with major, minor, patch
+  bool read_version_(BusClass bus_class, uint8_t *version);
+  bool dfu_get_version_();
+
+  bool write_output_config_();
+#ifdef USE_RESPEAKER_XVF3800_BEAM_LOCK
+  void write_beam_lock_(float radians);
+#endif
+#ifdef USE_RESPEAKER_XVF3800_LED_RING
+  uint8_t *led_pixels_() { return &this->led_frame_[XMOS_HEADER_BYTES]; }
+  void flush_led_frame_();
+#endif
+  void publish_bus_utilization_();
+
+  // All XMOS traffic goes through these so the bus scheduler can account it
+  i2c::ErrorCode bus_write_(BusClass bus_class, const uint8_t *data, size_t len);
+  i2c::ErrorCode bus_read_(BusClass bus_class, uint8_t *data, size_t len);
+  i2c::ErrorCode bus_write_read_(BusClass bus_class, const uint8_t *write_data, size_t write_len, uint8_t *read_data,
+                                 size_t read_len);
+  // Request write, STOP, then response read, with no other transfer in between
+  i2c::ErrorCode bus_request_(BusClass bus_class, const uint8_t *request, size_t request_len, uint8_t *response,
+                              size_t response_len);
+  // The unlocked halves of the wrappers above
+  i2c::ErrorCode timed_write_(BusClass bus_class, const uint8_t *data, size_t len);
+  i2c::ErrorCode timed_read_(BusClass bus_class, uint8_t *data, size_t len);
+  // Called by the bus wrappers (main loop or control task) after every transfer
+  void note_transaction_(i2c::ErrorCode err, uint32_t duration_us);
+
+  void health_loop_();
+  // One DFU_GETVERSION round trip; exercises the bus and the XMOS control servicer
+  bool health_probe_();
+  void enter_health_state_(HealthState state, uint32_t delay_ms);
+  // Puts back what the hub had set on the XMOS; `rebooted` also restores the audio configuration
+  void restore_state_(bool rebooted);
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+  // Runs on the control task
+  void execute_control_command_(ControlCommand &command);
+#endif
+  bool write_aec_delay_(int32_t delay);
+#ifdef USE_RESPEAKER_XVF3800_ACOUSTIC_PROFILES
+  // Forgets the written values, e.g. after the XMOS rebooted
+  void invalidate_acoustic_shadow_();
+#endif
+  // Writes the output routing and the calibrated AEC delay once the firmware is confirmed
+  void apply_audio_config_();
+
+#if defined(USE_RESPEAKER_XVF3800_TELEMETRY) || defined(USE_RESPEAKER_XVF3800_CAPTURE)
+  // Starts the azimuth, VNR and GPO reads as one sweep; the caller admitted them
+  void read_status_(ReadSweep &sweep);
+#endif
+#ifdef USE_RESPEAKER_XVF3800_TELEMETRY
+  // Queues the azimuth, VNR and GPO reads back to back; the last completion publishes the frame
+  void telemetry_sweep_();
+  void telemetry_read_(uint8_t read, bool ok, const uint8_t *data);
+  void publish_telemetry_();
+#endif
+  // Registers the child entities and periodic features as poll table tasks
+  void setup_poll_table_();
+  // One tick of the poll table: the reads of every due task, admitted and queued as one sweep
+  void poll_sweep_();
+#ifdef USE_RESPEAKER_XVF3800_VNR
+  void handle_vnr_(bool ok, uint8_t vnr);
+#endif
+#ifdef USE_RESPEAKER_XVF3800_BEAM_ENERGY
+  void handle_beam_energy_(const uint8_t *energies);
+#ifdef USE_RESPEAKER_XVF3800_LED_RING
+  void render_energy_effect_(float level_db);
+#endif
+#endif
+#ifdef USE_RESPEAKER_XVF3800_EXCLUSION_ZONES
+  // Feeds a cmd 75 read into the direction history
+  void add_direction_sample_(const uint8_t *azimuths);
+#endif
+#ifdef USE_RESPEAKER_XVF3800_DSP_DIAGNOSTICS
+  void dsp_diagnostics_sweep_();
+  void dsp_read_(uint8_t read, bool ok, const uint8_t *data);
+  void publish_dsp_diagnostics_();
+#endif
+#ifdef USE_RESPEAKER_XVF3800_CAPTURE
+  // Queues the azimuth, VNR and GPO reads of one record; the last completion stores it
+  void capture_sample_();
+  void capture_read_(uint8_t read, bool ok, const uint8_t *data);
+  void capture_export_step_();
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_AEC_CALIBRATION
+  void aec_calibration_loop_();
+  void calibration_read_(uint8_t read, bool ok, const uint8_t *data);
+  void record_calibration_sample_();
+  void feed_calibration_probe_();
+  void finish_aec_calibration_();
+#endif
 
   GPIOPin *reset_pin_{nullptr};
+  uint8_t instance_index_{0};
+
+  std::atomic<uint8_t> consecutive_failures_{0};
+  std::atomic<uint8_t> consecutive_slow_{0};
+  bool health_slow_reported_{false};
+  uint8_t health_max_failures_{3};
+  uint32_t health_max_latency_us_{50000};
+  bool health_armed_{false};  // set once the boot-time version check passed
+  HealthState health_state_{HEALTH_OK};
+  uint8_t health_attempts_{0};
+  uint32_t health_next_ms_{0};
+  uint32_t health_fault_ms_{0};
+  uint32_t health_recoveries_{0};
+
   #ifdef USE_BINARY_SENSOR
   binary_sensor::BinarySensor *mute_state_{nullptr};
   #endif
@@ -272,39 +801,235 @@ class RespeakerXVF3800 : public i2c::I2CDevice, public Component {
 
   bool get_firmware_version_();
 
+  uint8_t firmware_version_major_{0};
+  uint8_t firmware_version_minor_{0};
+  uint8_t firmware_version_patch_{0};
+
+#ifdef USE_RESPEAKER_XVF3800_DFU
   uint8_t dfu_state_{0};
   uint8_t dfu_status_{0};
   uint32_t dfu_status_next_req_delay_{0};
 
   uint8_t const *firmware_bin_{nullptr};
   uint32_t firmware_bin_length_{0};
+  const char *firmware_bin_md5_{""};
   uint8_t firmware_bin_version_major_{0};
   uint8_t firmware_bin_version_minor_{0};
   uint8_t firmware_bin_version_patch_{0};
 
-  uint8_t firmware_version_major_{0};
-  uint8_t firmware_version_minor_{0};
-  uint8_t firmware_version_patch_{0};
-
   uint32_t bytes_written_{0};
   uint32_t last_progress_{0};
   uint32_t last_ready_{0};
   uint32_t status_last_read_ms_{0};
   uint32_t update_start_time_{0};
   RespeakerXVF3800UpdaterStatus dfu_update_status_{UPDATE_OK};
+  HighFrequencyLoopRequester dfu_loop_requester_;
+  uint8_t dfu_max_retries_{3};
+  uint8_t dfu_attempts_{0};
+  uint32_t dfu_retry_at_ms_{0};
+  bool dfu_fell_back_{false};  // running the factory image after the upgrade slot kept failing
+  uint8_t dfu_prior_version_[3]{};  // what ran before the update started
+  // Hash of the image MD5 the last fallback gave up on; 0 when none
+  ESPPreferenceObject dfu_fallback_pref_;
+  uint32_t dfu_fallback_image_{0};
+  uint8_t dfu_frame_[DFU_DNLOAD_FRAME_BYTES]{};
+#endif
+#ifdef USE_RESPEAKER_XVF3800_DFU_SCHEDULE
+  DfuScheduler dfu_schedule_;
+  ESPPreferenceObject dfu_rate_pref_;
+  uint32_t dfu_rate_{DFU_DEFAULT_BYTES_PER_S};  // bytes per second
+#ifdef USE_TIME
+  time::RealTimeClock *dfu_time_{nullptr};
+#endif
+#ifdef USE_VOICE_ASSISTANT
+  voice_assistant::VoiceAssistant *dfu_voice_assistant_{nullptr};
+#endif
+#ifdef USE_BINARY_SENSOR
+  binary_sensor::BinarySensor *update_pending_sensor_{nullptr};
+#endif
+  sensor::Sensor *update_duration_sensor_{nullptr};
+#endif
+
+  // Audio manager output; sample rate 0 leaves the firmware defaults untouched
+  uint8_t output_left_[2]{0, 0};
+  uint8_t output_right_[2]{0, 0};
+  uint32_t output_sample_rate_{0};
+  OutputWordFormat output_word_format_{OUTPUT_WORD_INT32};
 
-  // Child components
+  // Child entities
+#ifdef USE_RESPEAKER_XVF3800_MUTE_SWITCH
   MuteSwitch *mute_switch_{nullptr};
+  uint32_t mute_switch_interval_{1000};
+#endif
+#ifdef USE_RESPEAKER_XVF3800_DFU_VERSION
   DFUVersionTextSensor *dfu_version_sensor_{nullptr};
+  uint32_t dfu_version_interval_{30000};
+#endif
+#ifdef USE_RESPEAKER_XVF3800_LED_BEAM_SENSOR
   LEDBeamSensor *led_beam_sensor_{nullptr};
+  uint32_t led_beam_interval_{100};
+#endif
+  PollTable poll_table_;
+  ReadSweep poll_reads_;
 
+#ifdef USE_RESPEAKER_XVF3800_BEAM_LOCK
   // Beam-lock state. While true, read_led_beam_direction() reads beam-1 (the
   // pinned fixed beam) from the chip instead of the auto-select beam, so the
   // LED ring stays pointed at the captured wake-word direction.
   bool beam_locked_{false};
+  float locked_azimuth_{0};
+#endif
+
+  bool voice_active_{false};
+#ifdef USE_RESPEAKER_XVF3800_TELEMETRY
+  text_sensor::TextSensor *telemetry_sensor_{nullptr};
+  uint32_t telemetry_interval_{1000};
+  ReadSweep telemetry_reads_;
+  bool telemetry_azimuth_ok_{false};
+  int16_t telemetry_azimuth_deg_[4]{};
+  bool telemetry_vnr_ok_{false};
+  uint8_t telemetry_vnr_{0};
+  bool telemetry_gpo_ok_{false};
+  uint8_t telemetry_gpo_[GPO_GPO_READ_NUM_BYTES]{};
+  uint32_t telemetry_busy_us_{0};
+  uint32_t telemetry_last_ms_{0};
+#endif
+#ifdef USE_RESPEAKER_XVF3800_VNR
+  uint32_t vnr_interval_{100};
+  sensor::Sensor *vnr_sensor_{nullptr};
+#ifdef USE_BINARY_SENSOR
+  binary_sensor::BinarySensor *voice_activity_sensor_{nullptr};
+#endif
+  uint8_t vad_on_threshold_{60};
+  uint8_t vad_off_threshold_{40};
+  uint32_t vad_attack_ms_{50};
+  uint32_t vad_release_ms_{500};
+  bool vad_pending_{false};  // VNR is past the threshold for a state change
+  uint32_t vad_pending_since_ms_{0};
+#endif
+#ifdef USE_RESPEAKER_XVF3800_BEAM_ENERGY
+  uint32_t beam_energy_interval_{100};
+  sensor::Sensor *beam_energy_sensors_[4]{};
+  float beam_energy_min_db_{-60};
+  float beam_energy_max_db_{0};
+  int8_t beam_energy_led_{-1};  // LED the tracked beam points to; -1 until an azimuth was read
+#ifdef USE_RESPEAKER_XVF3800_LED_RING
+  bool energy_effect_active_{false};
+  uint32_t energy_effect_color_{0x00A0FF};
+  uint8_t energy_effect_brightness_{255};
+  uint32_t energy_effect_release_ms_{300};
+  float energy_effect_level_{0};  // 0-1, instant attack, linear release
+  uint32_t energy_effect_last_ms_{0};
+  uint32_t energy_effect_frame_[12]{};
+#endif
+#endif
+#ifdef USE_RESPEAKER_XVF3800_CAPTURE
+  CaptureBuffer capture_;
+  uint32_t capture_capacity_{2048};
+  uint32_t capture_interval_{100};
+  bool capture_running_{false};
+  ReadSweep capture_reads_;  // fills capture_record_
+  CaptureRecord capture_record_{};
+  bool capture_exporting_{false};
+  size_t capture_export_index_{0};
+#endif
+#ifdef USE_RESPEAKER_XVF3800_DSP_DIAGNOSTICS
+  uint32_t dsp_interval_{60000};
+  std::vector<DspRead> dsp_reads_;
+  std::vector<DspDiagnostic> dsp_diagnostics_;
+  std::vector<uint8_t> dsp_values_;  // payloads of all reads, back to back
+  ReadSweep dsp_diagnostic_reads_;
+#endif
+#ifdef USE_RESPEAKER_XVF3800_EXCLUSION_ZONES
+  ExclusionZones exclusion_zones_;
+  uint32_t exclusion_interval_{100};
+  ESPPreferenceObject exclusion_pref_;
+  uint32_t last_wake_ms_{0};
+  int16_t last_wake_direction_{-1};  // degrees, -1 if unknown or already reported
+#endif
+
+  BusScheduler bus_scheduler_;
+#ifdef USE_RESPEAKER_XVF3800_TRACE
+  TraceBuffer trace_;
+#endif
+  uint32_t bus_report_interval_{0};
+  sensor::Sensor *bus_utilization_sensor_{nullptr};
+
+#ifdef USE_RESPEAKER_XVF3800_CONTROL_TASK
+  ControlTask control_task_;
+  // Serialises transactions between the control task and the synchronous paths (setup, DFU, calibration)
+  Mutex transport_lock_;
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_LED_RING
+  // Latest LED ring frame, pixels behind the protocol header so it is sent in place;
+  // held back while the LED class is over budget
+  uint8_t led_frame_[XMOS_HEADER_BYTES + LED_RING_PAYLOAD_BYTES]{};
+  bool led_frame_pending_{false};
+  bool led_frame_valid_{false};  // a frame was set at least once, so there is something to restore
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_LED_ANIMATIONS
+  LedAnimationPlayer led_animations_;
+  uint32_t led_animation_interval_{50};
+  uint32_t led_animation_last_ms_{0};
+#endif
+
+#ifdef USE_RESPEAKER_XVF3800_ACOUSTIC_PROFILES
+  std::vector<AcousticProfile> acoustic_profiles_;
+  // Per parameter: "known" byte followed by the last value written by a profile
+  std::vector<uint8_t> acoustic_shadow_;
+  // Last profile applied successfully; re-applied after an XMOS reset
+  const char *active_acoustic_profile_{nullptr};
+  sensor::Sensor *profile_latency_sensor_{nullptr};
+#endif
+
+  int32_t aec_delay_{0};
+#ifdef USE_RESPEAKER_XVF3800_AEC_CALIBRATION
+  ESPPreferenceObject aec_delay_pref_;
+  bool aec_delay_valid_{false};
+
+  speaker::Speaker *calibration_speaker_{nullptr};
+  int32_t calibration_min_delay_{0};
+  int32_t calibration_max_delay_{64};
+  int32_t calibration_step_{4};
+  uint32_t calibration_dwell_ms_{1500};
+  CallbackManager<void(bool)> calibration_callback_{};
+
+  bool calibration_active_{false};
+  int32_t calibration_candidate_{0};
+  uint32_t calibration_candidate_start_ms_{0};
+  uint32_t calibration_last_sample_ms_{0};
+  uint16_t calibration_samples_{0};
+  uint16_t calibration_converged_samples_{0};
+  float calibration_energy_sum_{0};
+  // One sample is two async reads; the generation ties them to the candidate they were taken for
+  ReadSweep calibration_reads_;
+  uint8_t calibration_generation_{0};
+  uint8_t calibration_sample_generation_{0};
+  bool calibration_sample_ok_{false};
+  bool calibration_sample_converged_{false};
+  float calibration_sample_energy_{0};
+  int32_t calibration_best_delay_{0};
+  float calibration_best_converged_{-1};
+  float calibration_best_energy_{0};
+
+  // 16 kHz mono noise probe, regenerated chunk by chunk from an LCG
+  int16_t probe_buffer_[256];
+  size_t probe_offset_{sizeof(probe_buffer_)};
+  uint32_t probe_seed_{1};
+#endif
   
+  // Sends a frame whose payload already sits at frame[XMOS_HEADER_BYTES]; the header is filled in place.
+  bool xmos_write_frame_(uint8_t resid, uint8_t cmd, uint8_t *frame, uint8_t payload_len, BusClass bus_class);
+
   // Helper method for XMOS communication
-  void xmos_write_bytes(uint8_t resid, uint8_t cmd, const uint8_t *value, uint8_t write_byte_num);
+  bool xmos_write_bytes(uint8_t resid, uint8_t cmd, const uint8_t *value, uint8_t write_byte_num,
+                        BusClass bus_class = BUS_CLASS_CONTROL);
+  // Reads a parameter payload (without the status byte), retrying on CTRL_WAIT/SERVICER_COMMAND_RETRY.
+  // `last_status` receives the final XMOS status byte, XMOS_STATUS_I2C_ERROR if the transfer failed.
+  bool xmos_read_bytes(uint8_t resid, uint8_t cmd, uint8_t *value, uint8_t read_byte_num,
+                       BusClass bus_class = BUS_CLASS_CONTROL, uint8_t *last_status = nullptr);
 
   // Reads one of the four AEC azimuth slots (radians) returned by cmd 75:
   //   0 = beam 1 (fixed beam 1 when fixed mode is on)
@@ -312,7 +1037,7 @@ class RespeakerXVF3800 : public i2c::I2CDevice, public Component {
   //   2 = free-running beam
   //   3 = auto-select beam (default — what the adaptive LED follows)
   // Returns true on success. Shared by read_led_beam_direction() and lock_beam().
-  bool read_azimuth_radians_(float &out_radians, uint8_t beam_index = 3);
+  bool read_azimuth_radians_(float &out_radians, uint8_t beam_index = 3, BusClass bus_class = BUS_CLASS_CONTROL);
 };
 
 }  // namespace respeaker_xvf3800
@@ -0,0 +1,90 @@
+#include "room_direction.h"
+
+#include "esphome/core/log.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+static const char *const TAG = "respeaker_xvf3800.room_direction";
+
+static const uint8_t AUTO_SELECT_BEAM = 3;
+
+void RoomDirectionSensor::dump_config() {
+  LOG_SENSOR("", "Respeaker Room Direction", this);
+  for (const auto &array : this->arrays_) {
+    ESP_LOGCONFIG(TAG, "  Array at 0x%02X, rotated %.0f deg", array.hub->get_i2c_address(),
+                  array.rotation * 180.0f / (float) M_PI);
+  }
+}
+
+void RoomDirectionSensor::setup() {
+  this->reads_.set_handlers([this](uint8_t read, bool ok, const uint8_t *data) { this->handle_read_(read, ok, data); },
+                            [this]() { this->publish_merged_(); });
+}
+
+// Read 2n is array n's azimuth, read 2n + 1 its energy
+void RoomDirectionSensor::update() {
+  if (this->reads_.is_running()) {
+    return;  // previous sweep still queued
+  }
+
+  this->reads_.begin(2 * this->arrays_.size());
+  for (uint8_t i = 0; i < this->arrays_.size(); i++) {
+    RespeakerXVF3800 *hub = this->arrays_[i].hub;
+    if (!hub->is_healthy() || !ReadSweep::admit(hub, BUS_CLASS_TELEMETRY, 2, 2 * 4 * sizeof(float))) {
+      this->reads_.fail(2 * i);
+      this->reads_.fail(2 * i + 1);
+      continue;
+    }
+    this->reads_.read(hub, BUS_CLASS_TELEMETRY, 2 * i, AEC_SERVICER_RESID, AEC_AZIMUTH_VALUES_CMD, 4 * sizeof(float));
+    this->reads_.read(hub, BUS_CLASS_TELEMETRY, 2 * i + 1, AEC_SERVICER_RESID, AEC_SPENERGY_VALUES_CMD,
+                      4 * sizeof(float));
+  }
+}
+
+void RoomDirectionSensor::handle_read_(uint8_t read, bool ok, const uint8_t *data) {
+  Array &array = this->arrays_[read / 2];
+  if (read % 2 == 0) {
+    if (ok) {
+      memcpy(&array.azimuth, &data[AUTO_SELECT_BEAM * sizeof(float)], sizeof(float));
+    }
+    array.azimuth_ok = ok;
+  } else {
+    if (ok) {
+      memcpy(&array.energy, &data[AUTO_SELECT_BEAM * sizeof(float)], sizeof(float));
+    }
+    array.energy_ok = ok;
+  }
+}
+
+void RoomDirectionSensor::publish_merged_() {
+  // Energy-weighted circular mean in the room frame
+  float x = 0.0f;
+  float y = 0.0f;
+  for (const auto &array : this->arrays_) {
+    if (!array.azimuth_ok || !array.energy_ok || !(array.energy > 0.0f)) {
+      continue;  // no fresh azimuth (silence) or nothing heard
+    }
+    const float direction = array.azimuth + array.rotation;
+    x += array.energy * cosf(direction);
+    y += array.energy * sinf(direction);
+  }
+  if (x == 0.0f && y == 0.0f) {
+    return;
+  }
+
+  float degrees = roundf(atan2f(y, x) * 180.0f / (float) M_PI);
+  if (degrees < 0.0f) {
+    degrees += 360.0f;
+  }
+  ESP_LOGV(TAG, "Room direction: %.0f deg", degrees);
+  if (!this->has_state() || this->get_raw_state() != degrees) {
+    this->publish_state(degrees);
+  }
+}
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "respeaker_xvf3800.h"
+
+#include <vector>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+// Merges the auto-select beam of several arrays into one room-level direction. Each array's
+// azimuth is turned into the room frame by its mounting rotation and weighted by the beam's
+// speech energy, so the array closest to the talker dominates. Arrays are treated as co-located
+// (far field); their positions are not modelled.
+class RoomDirectionSensor : public sensor::Sensor, public PollingComponent {
+ public:
+  void add_array(RespeakerXVF3800 *hub, float rotation_radians) { this->arrays_.push_back({hub, rotation_radians}); }
+  void setup() override;
+  void update() override;
+  void dump_config() override;
+
+ protected:
+  struct Array {
+    RespeakerXVF3800 *hub;
+    float rotation;
+    float azimuth{0};
+    float energy{0};
+    bool azimuth_ok{false};
+    bool energy_ok{false};
+  };
+
+  void handle_read_(uint8_t read, bool ok, const uint8_t *data);
+  void publish_merged_();
+
+  std::vector<Array> arrays_;
+  ReadSweep reads_;
+};
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
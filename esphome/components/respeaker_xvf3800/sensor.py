@@ -0,0 +1,57 @@
+import math
+
+import esphome.codegen as cg
+from esphome.components import sensor
+import esphome.config_validation as cv
+from esphome.const import CONF_ID, STATE_CLASS_MEASUREMENT, UNIT_DEGREES
+
+from . import RespeakerXVF3800, respeaker_xvf3800_ns
+
+CODEOWNERS = ["@formatBCE"]
+DEPENDENCIES = ["respeaker_xvf3800"]
+
+CONF_ARRAYS = "arrays"
+CONF_ROTATION = "rotation"
+
+RoomDirectionSensor = respeaker_xvf3800_ns.class_(
+    "RoomDirectionSensor", sensor.Sensor, cg.PollingComponent
+)
+
+# Room-level talker direction merged from several arrays, each rotated into the room frame
+CONFIG_SCHEMA = (
+    sensor.sensor_schema(
+        RoomDirectionSensor,
+        unit_of_measurement=UNIT_DEGREES,
+        accuracy_decimals=0,
+        state_class=STATE_CLASS_MEASUREMENT,
+        icon="mdi:compass-outline",
+    )
+    .extend(
+        {
+            cv.Required(CONF_ARRAYS): cv.All(
+                cv.ensure_list(
+                    cv.Schema(
+                        {
+                            cv.GenerateID(): cv.use_id(RespeakerXVF3800),
+                            # Room angle the array's 0 deg azimuth points to
+                            cv.Optional(CONF_ROTATION, default=0.0): cv.float_range(
+                                min=-360.0, max=360.0
+                            ),
+                        }
+                    )
+                ),
+                cv.Length(min=1),
+            ),
+        }
+    )
+    .extend(cv.polling_component_schema("250ms"))
+)
+
+
+async def to_code(config):
+    var = await sensor.new_sensor(config)
+    await cg.register_component(var, config)
+
+    for array in config[CONF_ARRAYS]:
+        hub = await cg.get_variable(array[CONF_ID])
+        cg.add(var.add_array(hub, math.radians(array[CONF_ROTATION])))
@@ -0,0 +1,74 @@
+#include "trace.h"
+
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+
+#include <cinttypes>
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+static const char *const TAG = "respeaker_xvf3800.trace";
+
+const char *trace_event_type_to_string(TraceEventType type) {
+  switch (type) {
+    case TRACE_XMOS_READ:
+      return "read";
+    case TRACE_XMOS_WRITE:
+      return "write";
+    case TRACE_AZIMUTH:
+      return "azimuth";
+    case TRACE_LED_BEAM:
+      return "led_beam";
+    case TRACE_MUTE:
+      return "mute";
+    case TRACE_LED_FRAME:
+      return "led_frame";
+    case TRACE_DAC_VOLUME:
+      return "dac_volume";
+    case TRACE_VNR:
+      return "vnr";
+    default:
+      return "unknown";
+  }
+}
+
+void TraceBuffer::record(TraceEventType type, uint8_t resid, uint8_t cmd, uint8_t status, uint32_t duration_us,
+                         float value) {
+  const uint32_t index = this->head_.fetch_add(1, std::memory_order_relaxed) % RESPEAKER_XVF3800_TRACE_SIZE;
+  TraceEvent &event = this->events_[index];
+  event.timestamp_us = micros();
+  event.duration_us = duration_us > UINT16_MAX ? UINT16_MAX : duration_us;
+  event.type = type;
+  event.resid = resid;
+  event.cmd = cmd;
+  event.status = status;
+  event.value = value;
+}
+
+size_t TraceBuffer::snapshot(TraceEvent *out, size_t max_events) const {
+  const uint32_t head = this->head_.load(std::memory_order_relaxed);
+  size_t count = head < RESPEAKER_XVF3800_TRACE_SIZE ? head : RESPEAKER_XVF3800_TRACE_SIZE;
+  if (count > max_events) {
+    count = max_events;
+  }
+  for (size_t i = 0; i < count; i++) {
+    out[i] = this->events_[(head - count + i) % RESPEAKER_XVF3800_TRACE_SIZE];
+  }
+  return count;
+}
+
+void TraceBuffer::dump() const {
+  const uint32_t head = this->head_.load(std::memory_order_relaxed);
+  const uint32_t count = head < RESPEAKER_XVF3800_TRACE_SIZE ? head : RESPEAKER_XVF3800_TRACE_SIZE;
+  ESP_LOGI(TAG, "Trace: %" PRIu32 " of %" PRIu32 " events", count, head);
+  for (uint32_t i = head - count; i != head; i++) {
+    const TraceEvent &event = this->events_[i % RESPEAKER_XVF3800_TRACE_SIZE];
+    ESP_LOGI(TAG, "%10" PRIu32 " %-10s resid=%3u cmd=%3u status=0x%02X %5uus %g", event.timestamp_us,
+             trace_event_type_to_string((TraceEventType) event.type), event.resid, event.cmd, event.status,
+             event.duration_us, event.value);
+  }
+}
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "esphome/core/defines.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef RESPEAKER_XVF3800_TRACE_SIZE
+#define RESPEAKER_XVF3800_TRACE_SIZE 256
+#endif
+
+namespace esphome {
+namespace respeaker_xvf3800 {
+
+enum TraceEventType : uint8_t {
+  TRACE_XMOS_READ = 0,  // status: last XMOS status byte (0xFF = I2C error), value: attempts
+  TRACE_XMOS_WRITE,     // status: i2c::ErrorCode, value: payload bytes
+  TRACE_AZIMUTH,        // status: beam slot, value: radians
+  TRACE_LED_BEAM,       // status: beam slot, value: LED index
+  TRACE_MUTE,           // value: 1 = muted
+  TRACE_LED_FRAME,      // value: lit LEDs
+  TRACE_DAC_VOLUME,     // resid: DAC register value, value: volume (0-1)
+  TRACE_VNR,            // status: 0xFF = read failed, value: VNR
+};
+
+const char *trace_event_type_to_string(TraceEventType type);
+
+struct TraceEvent {
+  uint32_t timestamp_us;
+  uint16_t duration_us;
+  uint8_t type;
+  uint8_t resid;
+  uint8_t cmd;
+  uint8_t status;
+  uint8_t reserved[2];
+  float value;
+};
+
+// Fixed-size ring of binary hot-path events. Recording is a slot claim plus a
+// 16-byte store, cheap enough for every bus transfer; formatting only happens in
+// dump(). Slots are claimed atomically, so the control task and the main loop
+// never write the same entry; a dump racing a record may show that one entry
+// half-updated.
+class TraceBuffer {
+ public:
+  void record(TraceEventType type, uint8_t resid, uint8_t cmd, uint8_t status, uint32_t duration_us, float value);
+
+  // Copies up to `max_events` of the newest events, oldest first. Returns the number copied.
+  size_t snapshot(TraceEvent *out, size_t max_events) const;
+  // Logs the buffer contents, oldest first.
+  void dump() const;
+  // Total number of events recorded since boot (including overwritten ones).
+  uint32_t get_recorded() const { return this->head_.load(std::memory_order_relaxed); }
+
+ protected:
+  TraceEvent events_[RESPEAKER_XVF3800_TRACE_SIZE]{};
+  std::atomic<uint32_t> head_{0};
+};
+
+}  // namespace respeaker_xvf3800
+}  // namespace esphome
@@ -0,0 +1,206 @@
+// Replays a beam-tracking capture exported by respeaker_xvf3800.export_capture through the
+// component's LED tracking code on a host, so tracking changes can be compared against a
+// recorded session without the hardware.
+//
+// Build:  g++ -std=c++17 -O2 -I esphome/components misc/capture_replay.cpp -o capture_replay
+// Usage:  capture_replay [--speed N] [--poll MS] [--verbose] < device.log
+//
+// --speed N   replay N times faster than recorded (default 0: no delays)
+// --poll MS   resample the capture at the LED beam sensor's polling interval instead of
+//             replaying every record
+// --verbose   print every LED change
+//
+// The log may contain anything else; only lines carrying the capture prefix are read. When it
+// holds several exports, the last complete one is replayed. Output is deterministic for a
+// given capture and options.
+
+#include "respeaker_xvf3800/beam_tracking.h"
+#include "respeaker_xvf3800/capture_format.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using esphome::respeaker_xvf3800::CAPTURE_FLAG_BEAM_LOCKED;
+using esphome::respeaker_xvf3800::CAPTURE_FORMAT_VERSION;
+using esphome::respeaker_xvf3800::CAPTURE_LINE_PREFIX;
+using esphome::respeaker_xvf3800::CAPTURE_UNKNOWN;
+using esphome::respeaker_xvf3800::CaptureRecord;
+using esphome::respeaker_xvf3800::led_index_for_azimuth;
+using esphome::respeaker_xvf3800::tracked_beam_slot;
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+// Reads the last complete capture from `in`. Returns false if there is none.
+static bool read_capture(std::istream &in, std::vector<CaptureRecord> &records, unsigned &interval) {
+  const std::string prefix = CAPTURE_LINE_PREFIX;
+  std::vector<uint8_t> bytes;
+  bool in_capture = false;
+  bool found = false;
+  unsigned version = 0, count = 0, record_size = 0, current_interval = 0, overwritten = 0;
+
+  std::string line;
+  while (std::getline(in, line)) {
+    const size_t pos = line.find(prefix);
+    if (pos == std::string::npos)
+      continue;
+    const char *payload = line.c_str() + pos + prefix.size();
+
+    if (sscanf(payload, "v%u records=%u record_size=%u interval=%u overwritten=%u", &version, &count, &record_size,
+               &current_interval, &overwritten) == 5) {
+      if (version != CAPTURE_FORMAT_VERSION || record_size != sizeof(CaptureRecord)) {
+        fprintf(stderr, "Skipping capture format v%u (record size %u); this tool reads v%u\n", version, record_size,
+                CAPTURE_FORMAT_VERSION);
+        in_capture = false;
+        continue;
+      }
+      bytes.clear();
+      in_capture = true;
+      continue;
+    }
+    if (!in_capture)
+      continue;
+    if (strncmp(payload, "END", 3) == 0) {
+      if (bytes.size() != (size_t) count * sizeof(CaptureRecord)) {
+        fprintf(stderr, "Skipping truncated capture: %zu of %u records\n", bytes.size() / sizeof(CaptureRecord),
+                count);
+      } else {
+        records.resize(count);
+        if (count > 0)
+          memcpy(records.data(), bytes.data(), bytes.size());
+        interval = current_interval;
+        found = true;
+        if (overwritten > 0)
+          fprintf(stderr, "Note: %u older records were overwritten on the device\n", overwritten);
+      }
+      in_capture = false;
+      continue;
+    }
+    // Hex runs until the first non-hex character (log colour codes, line endings)
+    for (const char *p = payload; hex_value(p[0]) >= 0 && hex_value(p[1]) >= 0; p += 2) {
+      bytes.push_back((uint8_t) (hex_value(p[0]) << 4 | hex_value(p[1])));
+    }
+  }
+  return found;
+}
+
+int main(int argc, char **argv) {
+  double speed = 0.0;
+  unsigned poll_ms = 0;
+  bool verbose = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+      speed = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--poll") == 0 && i + 1 < argc) {
+      poll_ms = (unsigned) atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--verbose") == 0) {
+      verbose = true;
+    } else {
+      fprintf(stderr, "Usage: %s [--speed N] [--poll MS] [--verbose] < device.log\n", argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<CaptureRecord> records;
+  unsigned interval = 0;
+  if (!read_capture(std::cin, records, interval)) {
+    fprintf(stderr, "No complete capture found\n");
+    return 1;
+  }
+  if (records.empty()) {
+    printf("Capture is empty\n");
+    return 0;
+  }
+
+  // Same decision as LEDBeamSensor::update(): failed reads keep the previous LED, a new LED
+  // index is published only when it differs from the current state
+  int led = -1;
+  int previous_led = -1;
+  unsigned changes = 0, flips = 0, polls = 0;
+  unsigned azimuth_ok = 0, azimuth_retry = 0, azimuth_i2c = 0;
+  unsigned vnr_count = 0, vnr_sum = 0, mute_count = 0, muted = 0;
+
+  const uint32_t start = records.front().timestamp_ms;
+  const uint32_t end = records.back().timestamp_ms;
+  uint32_t next_poll = start;
+  uint32_t last_time = start;
+  for (const CaptureRecord &record : records) {
+    if (poll_ms > 0) {
+      // The record holds the chip state until the next one; the sensor sees it only on a poll
+      if ((int32_t) (record.timestamp_ms - next_poll) < 0)
+        continue;
+      while ((int32_t) (record.timestamp_ms - next_poll) >= 0)
+        next_poll += poll_ms;
+    }
+    polls++;
+
+    if (speed > 0.0) {
+      const auto delay = std::chrono::duration<double, std::milli>((record.timestamp_ms - last_time) / speed);
+      std::this_thread::sleep_for(delay);
+    }
+    last_time = record.timestamp_ms;
+
+    if (record.vnr != CAPTURE_UNKNOWN) {
+      vnr_count++;
+      vnr_sum += record.vnr;
+    }
+    if (record.mute != CAPTURE_UNKNOWN) {
+      mute_count++;
+      muted += record.mute;
+    }
+
+    if (record.azimuth_status != 0) {
+      if (record.azimuth_status == 0xFF) {
+        azimuth_i2c++;
+      } else {
+        azimuth_retry++;
+      }
+      continue;
+    }
+    azimuth_ok++;
+
+    const uint8_t slot = tracked_beam_slot(record.flags & CAPTURE_FLAG_BEAM_LOCKED);
+    const int index = led_index_for_azimuth(record.azimuth[slot]);
+    if (index == led)
+      continue;
+    if (led >= 0) {
+      changes++;
+      if (index == previous_led)
+        flips++;  // A -> B -> A: tracking jitter rather than a talker moving
+    }
+    if (verbose)
+      printf("%10.3f s  LED %2d -> %2d  (slot %u, %.1f deg)\n", (record.timestamp_ms - start) / 1000.0, led, index,
+             slot, record.azimuth[slot] * 180.0f / (float) M_PI);
+    previous_led = led;
+    led = index;
+  }
+
+  const double span_s = (end - start) / 1000.0;
+  const double percent = 100.0 / polls;
+  printf("Records:       %zu over %.1f s (recorded every %u ms)\n", records.size(), span_s, interval);
+  if (poll_ms > 0)
+    printf("Polls:         %u at %u ms\n", polls, poll_ms);
+  printf("Azimuth reads: %.1f%% ok, %.1f%% retry, %.1f%% I2C error\n", azimuth_ok * percent, azimuth_retry * percent,
+         azimuth_i2c * percent);
+  printf("LED changes:   %u (%.1f per minute), %u of them flips back\n", changes,
+         span_s > 0.0 ? changes * 60.0 / span_s : 0.0, flips);
+  if (vnr_count > 0)
+    printf("Mean VNR:      %.1f\n", (double) vnr_sum / vnr_count);
+  if (mute_count > 0)
+    printf("Muted:         %.1f%%\n", muted * 100.0 / mute_count);
+  return 0;
+}
@@ -0,0 +1,178 @@
+// Host tests for the XVF3800 control task: the SPSC command ring and the order completions run
+// in. The worker runs on a std::thread here instead of a FreeRTOS task; the ring code is the same.
+//
+// Build:  g++ -std=c++17 -O2 -pthread -DUSE_RESPEAKER_XVF3800_CONTROL_TASK -I misc/host -I esphome/components
+//             misc/control_task_test.cpp esphome/components/respeaker_xvf3800/control_task.cpp -o control_task_test
+// Usage:  control_task_test
+//
+// Adding -fsanitize=thread checks the ring's memory ordering as well. Exits non-zero if any check
+// fails.
+
+#include "respeaker_xvf3800/control_task.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using esphome::respeaker_xvf3800::BUS_CLASS_CONTROL;
+using esphome::respeaker_xvf3800::BUS_CLASS_TELEMETRY;
+using esphome::respeaker_xvf3800::CONTROL_QUEUE_SIZE;
+using esphome::respeaker_xvf3800::ControlCommand;
+using esphome::respeaker_xvf3800::ControlTask;
+
+static int failures = 0;
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+      failures++; \
+    } \
+  } while (0)
+
+// Waits until `done` holds, giving up after two seconds
+template<typename F> static bool wait_for(F done) {
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+  return true;
+}
+
+// Fills the ring while the worker is held, checks the full ring refuses the next command, then
+// checks the worker runs the commands in order and their completions run in the same order, on
+// the main thread, and only from process_completions().
+static void test_ordering_and_full_ring() {
+  ControlTask task;
+  std::atomic<bool> hold{true};
+  std::atomic<uint32_t> executed{0};
+  std::vector<uint8_t> execution_order;
+  const std::thread::id main_thread = std::this_thread::get_id();
+  bool worker_on_main = false;
+
+  task.start([&](ControlCommand &command) {
+    while (hold.load(std::memory_order_acquire))
+      std::this_thread::yield();
+    worker_on_main |= std::this_thread::get_id() == main_thread;
+    execution_order.push_back(command.resid);
+    if (command.read) {
+      for (uint8_t i = 0; i < command.len; i++)
+        command.payload()[i] = command.resid + i;
+    }
+    command.ok = command.resid % 5 != 0;
+    executed.fetch_add(1, std::memory_order_release);
+  });
+
+  std::vector<uint8_t> completion_order;
+  bool completion_off_main = false;
+  bool payload_mismatch = false;
+  for (uint8_t i = 0; i < CONTROL_QUEUE_SIZE; i++) {
+    auto on_complete = [&, i](bool ok, const uint8_t *data) {
+      completion_off_main |= std::this_thread::get_id() != main_thread;
+      completion_order.push_back(i);
+      if (ok != (i % 5 != 0))
+        payload_mismatch = true;
+      if (ok && i % 2 == 0 && (data[0] != i || data[1] != i + 1))
+        payload_mismatch = true;
+    };
+    bool queued;
+    if (i % 2 == 0) {
+      queued = task.submit_read(BUS_CLASS_TELEMETRY, i, 0x80, 2, on_complete);
+    } else {
+      const uint8_t value = i;
+      queued = task.submit_write(BUS_CLASS_CONTROL, i, 0x01, &value, 1, on_complete);
+    }
+    CHECK(queued);
+  }
+  CHECK(task.get_pending() == CONTROL_QUEUE_SIZE);
+  CHECK(!task.submit_read(BUS_CLASS_TELEMETRY, 0xEE, 0x80, 1, [](bool, const uint8_t *) {}));
+
+  hold.store(false, std::memory_order_release);
+  CHECK(wait_for([&]() { return executed.load(std::memory_order_acquire) == CONTROL_QUEUE_SIZE; }));
+  // Executed but not reaped: completions wait for the main loop and keep their slots
+  CHECK(completion_order.empty());
+  CHECK(task.get_pending() == CONTROL_QUEUE_SIZE);
+  CHECK(!task.submit_read(BUS_CLASS_TELEMETRY, 0xEE, 0x80, 1, [](bool, const uint8_t *) {}));
+
+  task.process_completions();
+  CHECK(task.get_pending() == 0);
+  CHECK(completion_order.size() == CONTROL_QUEUE_SIZE);
+  for (uint8_t i = 0; i < completion_order.size(); i++)
+    CHECK(completion_order[i] == i);
+  task.stop();
+
+  CHECK(execution_order.size() == CONTROL_QUEUE_SIZE);
+  for (uint8_t i = 0; i < execution_order.size(); i++)
+    CHECK(execution_order[i] == i);
+  CHECK(!worker_on_main);
+  CHECK(!completion_off_main);
+  CHECK(!payload_mismatch);
+}
+
+// Streams commands through the ring with the worker running freely, reaping completions as the
+// main loop would, and checks every completion arrives once, in submission order, with its payload.
+static void test_stream() {
+  static const uint32_t COMMANDS = 20000;
+  ControlTask task;
+  task.start([](ControlCommand &command) {
+    // The read returns the sequence number the main loop put in resid/cmd
+    command.payload()[0] = command.resid;
+    command.payload()[1] = command.cmd;
+    command.ok = true;
+  });
+
+  uint32_t submitted = 0;
+  uint32_t completed = 0;
+  uint32_t out_of_order = 0;
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+  while (completed < COMMANDS && std::chrono::steady_clock::now() < deadline) {
+    while (submitted < COMMANDS) {
+      // Like the hub, back off on a full ring rather than letting submit refuse the command
+      if (task.get_pending() >= CONTROL_QUEUE_SIZE)
+        break;
+      const uint16_t seq = submitted & 0xFFFF;
+      const bool queued = task.submit_read(BUS_CLASS_TELEMETRY, seq & 0xFF, seq >> 8, 2,
+                                           [&completed, &out_of_order](bool ok, const uint8_t *data) {
+                                             const uint16_t expected = completed & 0xFFFF;
+                                             if (!ok || data[0] != (expected & 0xFF) || data[1] != (expected >> 8))
+                                               out_of_order++;
+                                             completed++;
+                                           });
+      CHECK(queued);
+      submitted++;
+    }
+    task.process_completions();
+  }
+  task.stop();
+
+  CHECK(completed == COMMANDS);
+  CHECK(out_of_order == 0);
+  CHECK(task.get_pending() == 0);
+}
+
+// A stopped task refuses new commands instead of queueing them for a worker that never runs
+static void test_stopped() {
+  ControlTask task;
+  CHECK(!task.submit_read(BUS_CLASS_TELEMETRY, 1, 1, 1, [](bool, const uint8_t *) {}));
+  task.start([](ControlCommand &command) { command.ok = true; });
+  CHECK(task.is_running());
+  task.stop();
+  CHECK(!task.is_running());
+  CHECK(!task.submit_read(BUS_CLASS_TELEMETRY, 1, 1, 1, [](bool, const uint8_t *) {}));
+}
+
+int main() {
+  test_ordering_and_full_ring();
+  test_stream();
+  test_stopped();
+  if (failures > 0) {
+    fprintf(stderr, "%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("all control task checks passed\n");
+  return 0;
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+// Host builds of the tools under misc/ pass the component's USE_* defines on the command line.
@@ -0,0 +1,20 @@
+#pragma once
+
+// Monotonic clock for host builds under misc/, counted from the first call.
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace esphome {
+
+inline uint32_t micros() {
+  static const auto start = std::chrono::steady_clock::now();
+  return (uint32_t) std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+inline uint32_t millis() { return micros() / 1000; }
+inline void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+inline void delayMicroseconds(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+
+}  // namespace esphome
@@ -0,0 +1,20 @@
+#pragma once
+
+// Component logging for host builds under misc/: warnings and errors go to stderr, the rest is
+// dropped so tool output stays deterministic.
+
+#include <cstdio>
+
+#define ESP_LOG_HOST_(level, tag, format, ...) fprintf(stderr, "[" level "][%s] " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOG_HOST_DROP_(tag, format, ...) \
+  do { \
+    if (0) \
+      fprintf(stderr, format, ##__VA_ARGS__); \
+  } while (0)
+
+#define ESP_LOGE(tag, format, ...) ESP_LOG_HOST_("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) ESP_LOG_HOST_("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ESP_LOG_HOST_DROP_(tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) ESP_LOG_HOST_DROP_(tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) ESP_LOG_HOST_DROP_(tag, format, ##__VA_ARGS__)
+#define ESP_LOGCONFIG(tag, format, ...) ESP_LOG_HOST_DROP_(tag, format, ##__VA_ARGS__)
@@ -0,0 +1,373 @@
+// Times the component's hot paths on a host: LED frame packing as set_led_ring() does it,
+// azimuth-to-LED mapping as the LED beam sensor does it, load_buf_() plus DFU_DNLOAD framing over
+// a firmware image, and the AIC3104 volume mapping with its register writes. Every transfer goes
+// to an in-memory stand-in for the I2C bus.
+//
+// Build:  g++ -std=c++17 -O2 -I esphome/components misc/hot_path_benchmark.cpp -o hot_path_benchmark
+// Usage:  hot_path_benchmark [--iterations N] [--byte-latency NS] [--image FILE]
+//                            [--save FILE] [--baseline FILE] [--tolerance PCT]
+//
+// --iterations N     operations per run (default 100000); every benchmark keeps the best of 5 runs
+// --byte-latency NS  time the bus stand-in spends per byte on the wire, address byte included
+//                    (default 0). 22500 models a 400 kHz bus, 90000 a 100 kHz one.
+// --image FILE       firmware image for the DFU benchmark (default: 512 KiB of generated data)
+// --save FILE        write the results as a baseline
+// --baseline FILE    compare against a saved baseline, taken at the same --byte-latency
+// --tolerance PCT    time per operation may exceed the baseline by this much (default 25)
+//
+// Reports time and cycles per operation, heap allocations per operation and the projected bus
+// occupancy at 100 kHz and 400 kHz. Exits non-zero on a regression: any heap allocation, a
+// change in the bytes a path puts on the wire, or time over the baseline's tolerance.
+
+#include "aic3104/dac_volume.h"
+#include "respeaker_xvf3800/beam_tracking.h"
+#include "respeaker_xvf3800/frame_packing.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLE_COUNTER 1
+#endif
+
+using esphome::aic3104::volume_to_dac;
+using esphome::respeaker_xvf3800::led_index_for_azimuth;
+using esphome::respeaker_xvf3800::load_dfu_block;
+using esphome::respeaker_xvf3800::pack_led_frame;
+
+// Wire layout, as in respeaker_xvf3800.h and aic3104.h
+static const uint8_t XMOS_HEADER_BYTES = 3;
+static const uint8_t LED_RING_PAYLOAD_BYTES = 48;
+static const uint8_t GPO_SERVICER_RESID = 20;
+static const uint8_t GPO_SERVICER_RESID_LED_RING_VALUE = 18;
+static const uint16_t MAX_XFER = 128;
+static const uint8_t DFU_DNLOAD_FRAME_BYTES = XMOS_HEADER_BYTES + 2 + MAX_XFER;
+static const uint8_t DFU_CONTROLLER_SERVICER_RESID = 240;
+static const uint8_t DFU_CONTROLLER_SERVICER_RESID_DFU_DNLOAD = 1;
+static const uint8_t AIC3104_PAGE_CTRL = 0x00;
+static const uint8_t AIC3104_LEFT_DAC_VOLUME = 0x2B;
+static const uint8_t AIC3104_RIGHT_DAC_VOLUME = 0x2C;
+
+static const int RUNS = 5;
+
+// Every allocation on the host counts; the hot paths are expected to make none
+static uint64_t allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  if (void *p = malloc(size > 0 ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static uint64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static uint64_t cycles() {
+#ifdef HAVE_CYCLE_COUNTER
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+// In-memory stand-in for the I2C bus: keeps the last frame, counts what would have gone on the
+// wire (one address byte per transaction) and holds the caller for `byte_latency_ns` per byte,
+// as a blocking transfer would.
+struct BenchmarkBus {
+  void write(const uint8_t *data, size_t len) {
+    const uint64_t start = this->byte_latency_ns > 0 ? now_ns() : 0;
+    memcpy(this->last, data, len < sizeof(this->last) ? len : sizeof(this->last));
+    this->transactions++;
+    this->bytes += len + 1;
+    if (this->byte_latency_ns > 0) {
+      const uint64_t until = start + (uint64_t) (len + 1) * this->byte_latency_ns;
+      while (now_ns() < until) {
+      }
+    }
+  }
+  // Projected wire time: 9 clocks per byte plus start/stop per transaction
+  double occupancy_us(uint32_t frequency) const {
+    return (this->bytes * 9.0 + this->transactions * 2.0) * 1e6 / frequency;
+  }
+
+  uint32_t byte_latency_ns{0};
+  uint8_t last[DFU_DNLOAD_FRAME_BYTES];
+  uint64_t transactions{0};
+  uint64_t bytes{0};
+};
+
+struct Benchmark {
+  const char *name;
+  // Bytes one operation puts on the wire; fixed by the protocol, so any change is a regression
+  double expected_bus_bytes;
+  // Runs the path over `bus` and returns the number of operations
+  std::function<uint32_t(BenchmarkBus &bus, uint32_t iterations)> run;
+};
+
+struct Result {
+  std::string name;
+  double ns_per_op;
+  double cycles_per_op;
+  double allocs_per_op;
+  double bus_bytes_per_op;
+  double bus_us_100k;
+  double bus_us_400k;
+};
+
+static volatile uint32_t sink = 0;
+
+static std::vector<Benchmark> make_benchmarks(const std::vector<uint8_t> &image) {
+  std::vector<Benchmark> benchmarks;
+
+  // LED packing + frame header, as set_led_ring() does
+  benchmarks.push_back({"led_pack", XMOS_HEADER_BYTES + LED_RING_PAYLOAD_BYTES + 1, [](BenchmarkBus &bus, uint32_t n) {
+                          uint8_t frame[XMOS_HEADER_BYTES + LED_RING_PAYLOAD_BYTES];
+                          uint32_t colors[12];
+                          for (uint32_t op = 0; op < n; op++) {
+                            for (uint32_t i = 0; i < 12; i++)
+                              colors[i] = (op + i) * 0x010203;
+                            sink = sink + pack_led_frame(colors, &frame[XMOS_HEADER_BYTES]);
+                            frame[0] = GPO_SERVICER_RESID;
+                            frame[1] = GPO_SERVICER_RESID_LED_RING_VALUE;
+                            frame[2] = LED_RING_PAYLOAD_BYTES;
+                            bus.write(frame, sizeof(frame));
+                          }
+                          return n;
+                        }});
+
+  // Azimuth (radians) to LED index, as the LED beam sensor does for every poll
+  benchmarks.push_back({"azimuth_map", 0, [](BenchmarkBus &, uint32_t n) {
+                          for (uint32_t op = 0; op < n; op++)
+                            sink = sink + led_index_for_azimuth((float) op * (2.0f * (float) M_PI / n) - (float) M_PI);
+                          return n;
+                        }});
+
+  // load_buf_() + DFU_DNLOAD framing over the whole image; one operation is one block
+  benchmarks.push_back({"dfu_framing", DFU_DNLOAD_FRAME_BYTES + 1, [&image](BenchmarkBus &bus, uint32_t n) {
+                          uint8_t frame[DFU_DNLOAD_FRAME_BYTES];
+                          uint32_t blocks = 0;
+                          while (blocks < n) {
+                            for (uint32_t offset = 0; offset < image.size() && blocks < n; offset += MAX_XFER) {
+                              frame[0] = DFU_CONTROLLER_SERVICER_RESID;
+                              frame[1] = DFU_CONTROLLER_SERVICER_RESID_DFU_DNLOAD;
+                              frame[2] = DFU_DNLOAD_FRAME_BYTES - XMOS_HEADER_BYTES;
+                              frame[3] = load_dfu_block(image.data(), image.size(), &frame[XMOS_HEADER_BYTES + 2],
+                                                        MAX_XFER, offset);
+                              frame[4] = 0;
+                              bus.write(frame, sizeof(frame));
+                              blocks++;
+                            }
+                          }
+                          return blocks;
+                        }});
+
+  // AIC3104 volume mapping + page select and two DAC register writes, as write_volume_() does
+  benchmarks.push_back({"dac_volume", 3 * 3, [](BenchmarkBus &bus, uint32_t n) {
+                          uint8_t frame[2];
+                          for (uint32_t op = 0; op < n; op++) {
+                            const uint8_t dac_val = volume_to_dac((float) op / n);
+                            frame[0] = AIC3104_PAGE_CTRL;
+                            frame[1] = 0x00;
+                            bus.write(frame, sizeof(frame));
+                            frame[0] = AIC3104_LEFT_DAC_VOLUME;
+                            frame[1] = dac_val;
+                            bus.write(frame, sizeof(frame));
+                            frame[0] = AIC3104_RIGHT_DAC_VOLUME;
+                            bus.write(frame, sizeof(frame));
+                          }
+                          return n;
+                        }});
+
+  return benchmarks;
+}
+
+// Best of RUNS; allocations and bus traffic are the same every run
+static Result measure(const Benchmark &benchmark, uint32_t iterations, uint32_t byte_latency_ns) {
+  Result result{benchmark.name, 0, 0, 0, 0, 0, 0};
+  for (int run = 0; run < RUNS; run++) {
+    BenchmarkBus bus;
+    bus.byte_latency_ns = byte_latency_ns;
+    const uint64_t start_allocations = allocations;
+    const uint64_t start_cycles = cycles();
+    const uint64_t start_ns = now_ns();
+    const uint32_t ops = benchmark.run(bus, iterations);
+    const double ns = (double) (now_ns() - start_ns) / ops;
+    const double cpu_cycles = (double) (cycles() - start_cycles) / ops;
+    if (run == 0 || ns < result.ns_per_op) {
+      result.ns_per_op = ns;
+      result.cycles_per_op = cpu_cycles;
+    }
+    result.allocs_per_op = (double) (allocations - start_allocations) / ops;
+    result.bus_bytes_per_op = (double) bus.bytes / ops;
+    result.bus_us_100k = bus.occupancy_us(100000) / ops;
+    result.bus_us_400k = bus.occupancy_us(400000) / ops;
+  }
+  return result;
+}
+
+static bool save_results(const char *path, uint32_t byte_latency_ns, const std::vector<Result> &results) {
+  FILE *file = fopen(path, "w");
+  if (file == nullptr)
+    return false;
+  fprintf(file, "byte_latency_ns %u\n", (unsigned) byte_latency_ns);
+  for (const Result &result : results)
+    fprintf(file, "%s %.3f\n", result.name.c_str(), result.ns_per_op);
+  fclose(file);
+  return true;
+}
+
+// Returns the number of regressions against the baseline, or -1 if it can't be used
+static int compare_baseline(const char *path, uint32_t byte_latency_ns, double tolerance,
+                            const std::vector<Result> &results) {
+  FILE *file = fopen(path, "r");
+  if (file == nullptr) {
+    fprintf(stderr, "Can't read baseline %s\n", path);
+    return -1;
+  }
+  unsigned baseline_latency = 0;
+  if (fscanf(file, "byte_latency_ns %u", &baseline_latency) != 1 || baseline_latency != byte_latency_ns) {
+    fprintf(stderr, "Baseline %s was taken at a different --byte-latency\n", path);
+    fclose(file);
+    return -1;
+  }
+  int regressions = 0;
+  char name[64];
+  double ns_per_op;
+  while (fscanf(file, "%63s %lf", name, &ns_per_op) == 2) {
+    for (const Result &result : results) {
+      if (result.name != name)
+        continue;
+      const double limit = ns_per_op * (1.0 + tolerance / 100.0);
+      if (result.ns_per_op > limit) {
+        fprintf(stderr, "REGRESSION %s: %.1f ns/op, baseline %.1f ns/op (limit %.1f)\n", name, result.ns_per_op,
+                ns_per_op, limit);
+        regressions++;
+      }
+    }
+  }
+  fclose(file);
+  return regressions;
+}
+
+static bool load_image(const char *path, std::vector<uint8_t> &image) {
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr)
+    return false;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), file)) > 0)
+    image.insert(image.end(), buf, buf + n);
+  fclose(file);
+  return !image.empty();
+}
+
+int main(int argc, char **argv) {
+  uint32_t iterations = 100000;
+  uint32_t byte_latency_ns = 0;
+  double tolerance = 25.0;
+  const char *image_path = nullptr;
+  const char *save_path = nullptr;
+  const char *baseline_path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      iterations = (uint32_t) strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--byte-latency") == 0 && i + 1 < argc) {
+      byte_latency_ns = (uint32_t) strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc) {
+      image_path = argv[++i];
+    } else if (strcmp(argv[i], "--save") == 0 && i + 1 < argc) {
+      save_path = argv[++i];
+    } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+      baseline_path = argv[++i];
+    } else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+      tolerance = atof(argv[++i]);
+    } else {
+      fprintf(stderr,
+              "Usage: %s [--iterations N] [--byte-latency NS] [--image FILE] [--save FILE] [--baseline FILE] "
+              "[--tolerance PCT]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (iterations == 0) {
+    fprintf(stderr, "--iterations must be at least 1\n");
+    return 2;
+  }
+
+  std::vector<uint8_t> image;
+  if (image_path != nullptr) {
+    if (!load_image(image_path, image)) {
+      fprintf(stderr, "Can't read image %s\n", image_path);
+      return 2;
+    }
+  } else {
+    // Not all block sizes divide it, so the last block is short as in a real image
+    image.resize(512 * 1024 + 77);
+    uint32_t state = 1;
+    for (uint8_t &byte : image) {
+      state = state * 1664525 + 1013904223;
+      byte = state >> 24;
+    }
+  }
+
+  const std::vector<Benchmark> benchmarks = make_benchmarks(image);
+  std::vector<Result> results;
+  int regressions = 0;
+  printf("%-12s %10s %10s %8s %9s %12s %12s\n", "", "ns/op", "cycles/op", "allocs", "bytes/op", "us/op@100k",
+         "us/op@400k");
+  for (const Benchmark &benchmark : benchmarks) {
+    const Result result = measure(benchmark, iterations, byte_latency_ns);
+    results.push_back(result);
+#ifdef HAVE_CYCLE_COUNTER
+    printf("%-12s %10.1f %10.1f %8.2f %9.1f %12.1f %12.1f\n", result.name.c_str(), result.ns_per_op,
+           result.cycles_per_op, result.allocs_per_op, result.bus_bytes_per_op, result.bus_us_100k,
+           result.bus_us_400k);
+#else
+    printf("%-12s %10.1f %10s %8.2f %9.1f %12.1f %12.1f\n", result.name.c_str(), result.ns_per_op, "-",
+           result.allocs_per_op, result.bus_bytes_per_op, result.bus_us_100k, result.bus_us_400k);
+#endif
+
+    if (result.allocs_per_op > 0.0) {
+      fprintf(stderr, "REGRESSION %s: %.2f heap allocations per operation\n", benchmark.name, result.allocs_per_op);
+      regressions++;
+    }
+    if (result.bus_bytes_per_op != benchmark.expected_bus_bytes) {
+      fprintf(stderr, "REGRESSION %s: %.1f bytes on the wire per operation, expected %.1f\n", benchmark.name,
+              result.bus_bytes_per_op, benchmark.expected_bus_bytes);
+      regressions++;
+    }
+  }
+  printf("DFU image of %zu bytes on the wire: %.1f s @100kHz, %.1f s @400kHz\n", image.size(),
+         results[2].bus_us_100k * ((image.size() + MAX_XFER - 1) / MAX_XFER) / 1e6,
+         results[2].bus_us_400k * ((image.size() + MAX_XFER - 1) / MAX_XFER) / 1e6);
+
+  if (baseline_path != nullptr) {
+    const int baseline_regressions = compare_baseline(baseline_path, byte_latency_ns, tolerance, results);
+    if (baseline_regressions < 0)
+      return 2;
+    regressions += baseline_regressions;
+  }
+  if (save_path != nullptr && !save_results(save_path, byte_latency_ns, results)) {
+    fprintf(stderr, "Can't write %s\n", save_path);
+    return 2;
+  }
+  if (regressions > 0) {
+    fprintf(stderr, "%d regression(s)\n", regressions);
+    return 1;
+  }
+  return 0;
+}